@@ -0,0 +1,282 @@
+// =============================================================================================
+// **************************     Countdown numbers game benchmark     *************************
+// =============================================================================================
+// Runs the solver over a fixed corpus of games and reports how fast it is, so changes to the solver
+// can be judged on the same games every time. The corpus (corpus.txt) has three kinds of game:
+//		easy		the target can be made with four numbers or fewer
+//		hard		the target needs five or all six numbers
+//		unsolvable	the target cannot be made at all (proven by trying every expression)
+// For each kind, and overall, the benchmark reports the permutations searched per second, the
+// percentiles of the time taken to find a solution and the worst time taken by any game.
+//
+// Results can be saved as a baseline and later runs compared against it. Any figure that is worse
+// than the baseline by more than the tolerance is flagged, and the benchmark exits with 1.
+//
+// Usage: Benchmark [--corpus file] [--engine rpn|dp] [--ranking file] [--deadline s] [--repeat n]
+//					[--baseline file] [--save-baseline file] [--tolerance percent]
+//		  Benchmark --make-corpus file [--seed n]
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<iomanip>
+#include<vector>
+#include<string>
+#include<map>
+#include<set>
+#include<random>
+#include<algorithm>
+#include<cstdlib>
+#include<cmath>
+#include "../Solver/Solver.h"
+
+const char* KINDS[] = { "easy", "hard", "unsolvable" };
+const int NUM_KINDS = 3;
+
+struct Game
+{
+	int kind;
+	std::vector<int> numbers;
+	int target;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Corpus
+// The fewest numbers needed to make target, 0 if it cannot be made. Worked out by brute force over
+// every subset of the numbers, separately from the solver so the corpus does not depend on it.
+int fewest_numbers(const std::vector<int>& numbers, int target)
+{
+	int n = numbers.size(), best = 0;
+	std::vector<std::set<int>> made(1 << n);
+	for (int mask = 1; mask < (1 << n); mask++)
+	{
+		int bits = 0;
+		for (int i = 0; i < n; i++) { bits += (mask >> i) & 1; }
+		if (bits == 1)
+		{
+			for (int i = 0; i < n; i++) { if (mask == (1 << i)) { made[mask].insert(numbers[i]); } }
+		}
+		for (int sub = (mask - 1) & mask; sub > 0; sub = (sub - 1) & mask)
+		{
+			for (int a : made[sub])
+			{
+				for (int b : made[mask ^ sub])
+				{
+					made[mask].insert(a + b);
+					made[mask].insert(a * b);
+					if (a > b) { made[mask].insert(a - b); }
+					if (a % b == 0) { made[mask].insert(a / b); }
+				}
+			}
+		}
+		if (made[mask].count(target) && (best == 0 || bits < best)) { best = bits; }
+	}
+	return best;
+}
+
+// Draws games with the seed until there are enough of each kind, and writes them to file. The file
+// is kept in the repository rather than drawn each run as the random numbers differ by compiler.
+bool make_corpus(const std::string& file, unsigned seed)
+{
+	const int wanted[NUM_KINDS] = { 40, 40, 20 };
+	int have[NUM_KINDS] = {};
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<> large_distr(0, 4), target_distr(101, 999);
+	std::ofstream out(file);
+	if (!out) { return false; }
+	out << "# Benchmark corpus drawn with seed " << seed << ": kind, six numbers, target\n";
+	while (have[0] < wanted[0] || have[1] < wanted[1] || have[2] < wanted[2])
+	{
+		std::vector<int> numbers = random_draw(large_distr(gen), gen);
+		int target = target_distr(gen), fewest = fewest_numbers(numbers, target);
+		int kind = (fewest == 0) ? 2 : (fewest <= 4) ? 0 : 1;
+		if (have[kind] == wanted[kind]) { continue; }
+		have[kind]++;
+		out << KINDS[kind];
+		for (int x : numbers) { out << " " << x; }
+		out << " " << target << "\n";
+	}
+	return true;
+}
+
+bool load_corpus(const std::string& file, std::vector<Game>& games)
+{
+	std::ifstream in(file);
+	if (!in) { return false; }
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.empty() || line[0] == '#') { continue; }
+		std::istringstream ss(line);
+		std::string kind;
+		Game g;
+		ss >> kind;
+		g.kind = std::find(KINDS, KINDS + NUM_KINDS, kind) - KINDS;
+		g.numbers.resize(6);
+		for (int& x : g.numbers) { ss >> x; }
+		ss >> g.target;
+		if (!ss || g.kind == NUM_KINDS) { return false; }
+		games.push_back(g);
+	}
+	return !games.empty();
+}
+
+// ------------------------------------------------------------------------------------------------
+// Figures
+// Every figure is named "<kind>.<figure>" (kind "all" for the whole corpus). For all of them apart
+// from perms_per_sec and solved a larger value is worse.
+typedef std::map<std::string, double> Figures;
+
+// Nearest rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p)
+{
+	int rank = std::max(1, (int)std::ceil(p / 100 * sorted.size()));
+	return sorted[rank - 1];
+}
+
+void add_figures(Figures& F, const std::string& name, const std::vector<GameResult>& results)
+{
+	std::vector<double> solve_ms;
+	double ms = 0, worst = 0, tried = 0;
+	int solved = 0;
+	for (const GameResult& res : results)
+	{
+		ms += res.ms; tried += res.tried; worst = std::max(worst, res.ms);
+		if (res.status == SOLVED) { solved++; solve_ms.push_back(res.ms); }
+	}
+	std::sort(solve_ms.begin(), solve_ms.end());
+	F[name + ".games"] = results.size();
+	F[name + ".solved"] = solved;
+	F[name + ".perms_per_sec"] = (ms > 0) ? tried / (ms / 1000) : 0;
+	F[name + ".worst_ms"] = worst;
+	if (solve_ms.empty()) { return; }
+	F[name + ".p50_ms"] = percentile(solve_ms, 50);
+	F[name + ".p90_ms"] = percentile(solve_ms, 90);
+	F[name + ".p99_ms"] = percentile(solve_ms, 99);
+}
+
+bool higher_is_better(const std::string& name)
+{
+	return name.find(".perms_per_sec") != std::string::npos || name.find(".solved") != std::string::npos;
+}
+
+bool load_figures(const std::string& file, Figures& F)
+{
+	std::ifstream in(file);
+	if (!in) { return false; }
+	std::string name;
+	double value;
+	while (in >> name >> value) { F[name] = value; }
+	return true;
+}
+bool save_figures(const std::string& file, const Figures& F)
+{
+	std::ofstream out(file);
+	if (!out) { return false; }
+	out << std::setprecision(10);
+	for (auto& f : F) { out << f.first << " " << f.second << "\n"; }
+	return true;
+}
+
+// Prints every figure next to its baseline, returns the number of regressions
+int compare(const Figures& F, const Figures& base, double tolerance)
+{
+	int regressions = 0;
+	std::cout << "\n        " << std::left << std::setw(28) << "figure" << std::right << std::setw(14) << "baseline" << std::setw(14) << "now" << std::setw(10) << "change" << "\n";
+	for (auto& f : F)
+	{
+		auto b = base.find(f.first);
+		if (b == base.end() || f.first.find(".games") != std::string::npos) { continue; }
+		double change = (b->second != 0) ? 100 * (f.second - b->second) / b->second : 0;
+		bool worse = higher_is_better(f.first) ? change < -tolerance : change > tolerance;
+		// Counts of solved games must not drop at all
+		if (f.first.find(".solved") != std::string::npos) { worse = f.second < b->second; }
+		std::cout << "        " << std::left << std::setw(28) << f.first << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(14) << b->second << std::setw(14) << f.second << std::setw(9) << change << "%" << (worse ? "  REGRESSION" : "") << "\n";
+		regressions += worse;
+	}
+	return regressions;
+}
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	std::string corpus_file = "corpus.txt", baseline, save, make;
+	std::string usage = std::string("Usage: ") + argv[0] + " [--corpus file] [--engine rpn|dp] [--ranking file] [--deadline s] [--repeat n]"
+		+ " [--baseline file] [--save-baseline file] [--tolerance percent] | --make-corpus file [--seed n]";
+	SolverOptions options;
+	options.cache_bytes = 0; // every game must really be solved, every time
+	double deadline = 30, tolerance = 20;
+	int repeat = 1;
+	unsigned seed = 2021;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--corpus" && i + 1 < argc) { corpus_file = argv[++i]; }
+		else if (arg == "--engine" && i + 1 < argc) { options.engine = argv[++i]; }
+		else if (arg == "--ranking" && i + 1 < argc) { options.ranking_file = argv[++i]; }
+		else if (arg == "--deadline" && i + 1 < argc) { deadline = std::atof(argv[++i]); }
+		else if (arg == "--repeat" && i + 1 < argc) { repeat = std::max(1, std::atoi(argv[++i])); }
+		else if (arg == "--baseline" && i + 1 < argc) { baseline = argv[++i]; }
+		else if (arg == "--save-baseline" && i + 1 < argc) { save = argv[++i]; }
+		else if (arg == "--tolerance" && i + 1 < argc) { tolerance = std::atof(argv[++i]); }
+		else if (arg == "--make-corpus" && i + 1 < argc) { make = argv[++i]; }
+		else if (arg == "--seed" && i + 1 < argc) { seed = std::atoi(argv[++i]); }
+		else { std::cout << "Unknown option " << arg << "\n" << usage << std::endl; return 1; }
+	}
+	if (!make.empty())
+	{
+		if (!make_corpus(make, seed)) { std::cerr << "Could not write " << make << std::endl; return 1; }
+		return 0;
+	}
+	std::vector<Game> games;
+	if (!load_corpus(corpus_file, games)) { std::cerr << "Could not read the corpus " << corpus_file << std::endl; return 1; }
+	Solver solver(options);
+	std::cout << "        " << games.size() << " games, engine " << options.engine << (solver.has_ranking() ? " with" : " without")
+		<< " ranking, best of " << repeat << "\n\n";
+	// Each game is solved repeat times and the quickest run kept, to take out some of the noise
+	std::vector<std::vector<GameResult>> by_kind(NUM_KINDS);
+	std::vector<GameResult> all;
+	for (const Game& g : games)
+	{
+		GameResult best;
+		for (int r = 0; r < repeat; r++)
+		{
+			GameResult res = solver.solve(g.numbers, g.target, deadline);
+			if (r == 0 || res.ms < best.ms) { best = res; }
+		}
+		by_kind[g.kind].push_back(best);
+		all.push_back(best);
+	}
+	Figures F;
+	for (int k = 0; k < NUM_KINDS; k++) { add_figures(F, KINDS[k], by_kind[k]); }
+	add_figures(F, "all", all);
+	std::cout << "        " << std::left << std::setw(12) << "kind" << std::right << std::setw(7) << "games" << std::setw(8) << "solved"
+		<< std::setw(16) << "perms/sec" << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "worst ms" << "\n";
+	for (std::string k : { "easy", "hard", "unsolvable", "all" })
+	{
+		std::cout << "        " << std::left << std::setw(12) << k << std::right << std::fixed << std::setprecision(0)
+			<< std::setw(7) << F[k + ".games"] << std::setw(8) << F[k + ".solved"] << std::setw(16) << F[k + ".perms_per_sec"]
+			<< std::setprecision(2);
+		// No percentiles when nothing was solved
+		for (std::string p : { ".p50_ms", ".p90_ms", ".p99_ms" })
+		{
+			if (F.count(k + p)) { std::cout << std::setw(10) << F[k + p]; }
+			else { std::cout << std::setw(10) << "-"; }
+		}
+		std::cout << std::setw(10) << F[k + ".worst_ms"] << "\n";
+	}
+	if (!save.empty())
+	{
+		if (!save_figures(save, F)) { std::cerr << "Could not write " << save << std::endl; return 1; }
+		std::cout << "\n        Baseline written to " << save << "\n";
+	}
+	if (!baseline.empty())
+	{
+		Figures base;
+		if (!load_figures(baseline, base)) { std::cerr << "Could not read the baseline " << baseline << std::endl; return 1; }
+		int regressions = compare(F, base, tolerance);
+		std::cout << "\n        " << regressions << " regression(s) beyond " << tolerance << "%" << std::endl;
+		return regressions > 0 ? 1 : 0;
+	}
+	return 0;
+}
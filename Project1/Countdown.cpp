@@ -6,7 +6,8 @@
 
 /*                   ---------------     Summary     ------------------
 * The program written here allows a user to play the countdown numbers game and the program 
-* attemps to solve the game within the predetermined time of 30 seconds.
+* attemps to solve the game within the predetermined time of 30 seconds. The solver itself is a 
+* separate library (Solver/Solver.h) so it can be used without the game, this file is the game.
 * 
 *	- How this code works -
 * This program works by utilising Reverse Polish Notation (RPN) and large amount of vector/array
@@ -49,24 +50,44 @@
 *			   |  Permute |   Permute     | 
 * 
 * In order to construct a list of all the permutations we shall use to search for a solution we
-* begin by making a list of the different ways one can choose 4 objects from the 8 inner objects
-* underlined above. These are then tested to see if they correspond to valid RPN (op,op,C,D) say 
-* would be invalid but (op,C,op,D) would be valid. This is then done on the remaining 4 objects
-* in the 8 inner objects, with invalid notations being eliminated. This gives 24192 valid ways of 
-* permuting the inner 8 objects that satisfy RPN rules. Furthermore there are guaranteed repeats 
-* in the operations used as there are 5 operations and only 4 at the disposal of the user, this 
-* in conjunction with the 15 ways one can have two fixed numbers at the beginning gives 
-* approximately 1.5 million different combinations. Totalling approximately 75 million permutations
+* place the 8 inner objects underlined above one at a time, dropping any placement that does not
+* correspond to valid RPN, (op,op,C,D) say would be invalid but (op,C,op,D) would be valid. This 
+* gives 24192 valid ways of permuting the inner 8 objects that satisfy RPN rules. This table, and
+* the sets of operations below, are worked out by the compiler so no time is spent on them when the
+* game starts. Furthermore there are guaranteed repeats in the operations used as there are 5 
+* operations and only 4 at the disposal of the user, this in conjunction with the 15 ways one can 
+* have two fixed numbers at the beginning gives approximately 1.5 million different combinations.
+* Totalling approximately 75 million permutations
 * where before we had 2 billion permutations. 
 * 
 *			--------- Optimisations and useful techniques ---------
 * [-] The rules of countdown aid in narrowing down the search of a solution to a given countdown
 * numbers game. If the running total becomes negative or a fraction we can bail on this solution
 * instantly to continue our search. 
+* [-] The small numbers come in pairs, so a draw often repeats a number. Starting pairs of the same
+* two numbers make the same games so only one of them is searched, and within a game the 
+* permutations that only swap two equal numbers (or two equal operations) are skipped.
+* [-] a + b and b + a are the same sum, as are a + (b + c) and (a + b) + c, so sums and products
+* are only worked out in one order: the larger operand first and chains bracketed from the left.
 * [-] As there are 15 ways one can have two fixed numbers at the beginning we can make use of 
-* multithreading to improve performance in the search of a solution. As the number of permutations 
-* we search through is always a multiple of 15, we can write 5 threads at the beginning (repeated 3
-* times to make up the 15). If the solution is found the solution is returned to the user.
+* multithreading to improve performance in the search of a solution. A pool with one thread per
+* core is created at the start of the game, and every game to search is split into slices of the
+* permutations which the threads share out between them (stealing from each other when they run
+* out of work). If the solution is found the solution is returned to the user.
+* [-] The slices are run best first: after the first few (in the order of the search ranking) a
+* couple of permutations of every slice left are tried, and the slices coming closest to the target
+* go next.
+* [-] When built for AVX2 (or SSE4.1) eight games are evaluated at once, one in each lane of a 
+* vector register, as every game walks the same table of permutations (see eval_lanes).
+* [-] Running with --engine dp swaps the RPN search for a subset dynamic programming solver which 
+* works out every value each subset of the numbers can make. This takes milliseconds and, unlike 
+* the RPN search, can tell the user that a game has no solution (and what the closest value is).
+* [-] With --nearest the RPN search also keeps track of the closest value it has made, so when the
+* target cannot be reached the closest expression (within 10, as scored in the show) is returned.
+* [-] Variant games with more (or fewer) numbers, --tiles n, are solved with the dp solver, as the
+* RPN tables are built for six numbers.
+* [-] In batch mode --all searches every game to the end and writes each distinct solution as it
+* is found, rather than stopping at the first.
 * 
 * 
 * 
@@ -92,6 +113,8 @@
 #include<stack>
 #include<thread>
 #include<iterator>
+#include "Solver/Solver.h"
+#include "Server.h"
 #ifndef MVECTOR_H // the 'include guard'
 #define MVECTOR_H // see C++ Primer Sec. 2.9.2
 
@@ -185,279 +208,281 @@ std::vector<std::string> RPN(MVector v)
 	}
 	return RPNs;
 } 
-using namespace std;
-void makeCombn(vector<vector<int>>& ans, vector<int>& tmp, int n, int left, int k)
+
+// ------------------------------------------------------------------------------------------------
+// Batch solving
+// Reads games one per line, the numbers (six for the standard game, up to MAX_TILES) followed by 
+// the target separated by spaces or commas (blank lines and lines starting with # are skipped), 
+// and solves them one after another with the same Solver. One result is written per game as CSV or
+// JSON Lines.
+std::string csv_field(const std::string& str)
 {
-	if (k == 0)
+	std::string out = "\"";
+	for (char c : str)
 	{
-		ans.push_back(tmp);
-		return;
+		if (c == '"') { out += '"'; }
+		out += c;
 	}
-	for (int i = left; i <= n; i++)
+	return out + "\"";
+}
+std::string json_string(const std::string& str)
+{
+	std::string out = "\"";
+	for (char c : str)
 	{
-		tmp.push_back(i);
-		makeCombn(ans, tmp, n, i + 1, k - 1);
-		tmp.pop_back();
+		if (c == '"' || c == '\\') { out += '\\'; }
+		out += c;
 	}
+	return out + "\"";
 }
-
-vector<vector<int>> makeCombi(int n, int k)
+// Writes out a solution in the notation chosen with --notation, "" if nothing was found
+std::string write_solution(const SolutionTrace& t, const std::string& notation)
 {
-	vector<vector<int>> ans;
-	vector<int> tmp;
-	makeCombn(ans, tmp, n, 1, k);
-	return ans;
+	if (t.length == 0) { return ""; }
+	else if (notation == "rpn") { return format_rpn(t); }
+	else if (notation == "json") { return format_json(t); }
+	else { return format_infix(t); }
 }
 
-std::string combn_solv(std::vector<std::string> NUMBERS_ops, int Target)
+// With --all every distinct solution of a game is written as soon as it is found, one per line (in
+// JSON Lines followed by a line of totals for the game, which go to standard error with CSV).
+AllSolutions write_all(std::ostream& out, const std::string& format, const std::string& notation, Solver& solver, int game, const std::vector<int>& v, bool valid, double seconds)
 {
-	std::vector<std::string> tmmp=NUMBERS_ops, str=NUMBERS_ops, str_tmp;
-	int tot_curr = 0, i = 0, no_ops = 0, soln = 0;
-	std::string str_curr, return_str;
-	while (no_ops < 5)
+	std::string numbers;
+	for (int k = 0; k + 1 < v.size(); k++) { numbers += (k ? " " : "") + std::to_string(v[k]); }
+	int target = (v.size() >= 2) ? v.back() : 0;
+	AllSolutions res = { NOT_FOUND, 0, 0, 0, 0 };
+	if (valid)
 	{
-		int op_exe = 0;
-		if (NUMBERS_ops[i] == "+")
+		res = solver.solve_all(std::vector<int>(v.begin(), v.end() - 1), target, [&](const SolutionTrace& t)
 		{
-			tot_curr = std::stoi(NUMBERS_ops[i - 1]) + std::stoi(NUMBERS_ops[i - 2]);
-			str_curr = "(" + str[i - 1] + " + " + str[i - 2] + ")";
-			op_exe = 1;
-		}		
-		else if (NUMBERS_ops[i] == "*")
+			std::string solution = write_solution(t, notation);
+			if (format == "csv") { out << game << "," << csv_field(numbers) << "," << target << "," << csv_field(solution) << "\n"; }
+			else { out << "{\"game\":" << game << ",\"solution\":" << ((notation != "json") ? json_string(solution) : solution) << "}\n"; }
+			return true;
+		}, seconds);
+	}
+	std::string status = valid ? status_name(res.status) : "invalid";
+	if (format == "csv")
+	{
+		std::cerr << "game " << game << ": " << status << ", " << res.solutions << " solutions (" << res.found << " with repeats) in "
+			<< res.ms << " ms, " << res.tried << " permutations" << std::endl;
+	}
+	else
+	{
+		std::string list = numbers;
+		std::replace(list.begin(), list.end(), ' ', ',');
+		out << "{\"game\":" << game << ",\"numbers\":[" << list << "],\"target\":" << target << ",\"status\":\"" << status
+			<< "\",\"solutions\":" << res.solutions << ",\"found\":" << res.found << ",\"time_ms\":" << res.ms << ",\"permutations\":" << res.tried << "}\n";
+	}
+	return res;
+}
+
+int run_batch(std::istream& in, std::ostream& out, const std::string& format, const std::string& notation, Solver& solver, double seconds, bool all)
+{
+	const char* work = (solver.options().engine == "dp") ? "values" : "permutations";
+	if (format == "csv" && all) { out << "game,numbers,target,solution\n"; }
+	else if (format == "csv") { out << "game,numbers,target,status,distance,solution,time_ms," << work << "\n"; }
+	std::string line;
+	int game = 0, solved = 0;
+	while (std::getline(in, line))
+	{
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::istringstream ss(line);
+		std::vector<int> v;
+		int x;
+		while (ss >> x) { v.push_back(x); }
+		std::string rest;
+		ss.clear();
+		if ((ss >> rest) && rest[0] == '#') { continue; }
+		if (v.empty() && rest.empty()) { continue; }
+		game++;
+		std::string numbers;
+		for (int k = 0; k + 1 < v.size(); k++) { numbers += (k ? " " : "") + std::to_string(v[k]); }
+		GameResult res{};
+		res.status = NOT_FOUND;
+		bool valid = v.size() >= 2 && v.size() <= MAX_TILES + 1 && rest.empty() && *std::min_element(v.begin(), v.end()) > 0;
+		if (all)
+		{
+			if (write_all(out, format, notation, solver, game, v, valid, seconds).status == SOLVED) { solved++; }
+			out.flush();
+			continue;
+		}
+		if (valid)
 		{
-			tot_curr = std::stoi(NUMBERS_ops[i - 1]) * std::stoi(NUMBERS_ops[i - 2]);
-			str_curr = "(" + str[i - 1] + " * " + str[i - 2] + ")";
-			op_exe = 1;
+			res = solver.solve(std::vector<int>(v.begin(), v.end() - 1), v.back(), seconds);
+			if (res.status == SOLVED) { solved++; }
 		}
-		else if (NUMBERS_ops[i] == "-")
+		std::string status = valid ? status_name(res.status) : "invalid";
+		std::string solution = write_solution(res.solution, notation);
+		int target = (v.size() >= 2) ? v.back() : 0;
+		if (format == "csv")
 		{
-			tot_curr = std::stoi(NUMBERS_ops[i - 2]) - std::stoi(NUMBERS_ops[i - 1]);
-			// Check that tot_curr does not become negative
-			if (tot_curr < 0) { return "0"; }
-			str_curr = "(" + str[i - 2] + " - " + str[i - 1] + ")";
-			op_exe = 1;
+			out << game << "," << csv_field(numbers) << "," << target << "," << status << "," << res.distance << ","
+				<< csv_field(solution) << "," << res.ms << "," << res.tried << "\n";
 		}
-		else if (NUMBERS_ops[i] == "/")
+		else
 		{
-			tot_curr = std::stoi(NUMBERS_ops[i - 2]) / std::stoi(NUMBERS_ops[i - 1]);
-			// Check that tot_curr is not a fraction
-			if (tot_curr * std::stoi(NUMBERS_ops[i - 1]) != std::stoi(NUMBERS_ops[i - 2])){ return "0"; }
-			str_curr = "(" + str[i - 2] + " / " + str[i - 1] + ")";
-			op_exe = 1;
+			std::string list = numbers;
+			std::replace(list.begin(), list.end(), ' ', ',');
+			out << "{\"game\":" << game << ",\"numbers\":[" << list << "]";
+			out << ",\"target\":" << target << ",\"status\":\"" << status << "\",\"distance\":" << res.distance
+				<< ",\"solution\":" << ((notation != "json") ? json_string(solution) : solution.empty() ? "null" : solution) << ",\"time_ms\":" << res.ms << ",\"" << work << "\":" << res.tried << "}\n";
 		}
-		i++;
+		out.flush();
+	}
+	CacheStats cache = solver.cache_stats();
+	std::cerr << game << " games, " << solved << " solved (cache: " << cache.hits << " hits, " << cache.misses << " misses, "
+		<< cache.evictions << " evictions)" << std::endl;
+	return 0;
+}
 
+// ------------------------------------------------------------------------------------------------
+// Writes the solver's counters to file, as JSON if the name ends in .json and in the Prometheus text
+// format otherwise. The file is written under another name and then renamed so that anything 
+// reading it never sees half a file.
+bool write_metrics(const std::string& file, const Solver& solver)
+{
+	bool json = file.size() >= 5 && file.compare(file.size() - 5, 5, ".json") == 0;
+	std::string tmp = file + ".tmp";
+	{
+		std::ofstream out(tmp);
+		if (!out) { return false; }
+		SolverMetrics M = solver.metrics();
+		out << (json ? metrics_json(M) : metrics_prometheus(M));
+		if (!out) { return false; }
+	}
+	std::remove(file.c_str());
+	return std::rename(tmp.c_str(), file.c_str()) == 0;
+}
 
-		// if vector is of length 3 then just work out the result and check
-		//if (NUMBERS_ops.size() < 3)
-		//{
-			//std::cout << tot_curr << std::endl;
-			//break;
-		//}
-		//std::cout << i << std::endl;
-		//Display_stdvector_str(NUMBERS_ops);
-		// if operation was executed (need to change vector)
-		if (op_exe == 1)
-		{
-			
-			no_ops++;
-			std::vector<std::string> tmp, str_tmp;
-			for (int j = 0; j < i - 3; j++)
-			{
-				tmp.push_back(NUMBERS_ops[j]);
-				str_tmp.push_back(str[j]);
-				soln = j + 1;
-			}
-			tmp.push_back(std::to_string(tot_curr));
-			str_tmp.push_back(str_curr);
-			for (int j = i; j < NUMBERS_ops.size(); j++)
-			{
-				tmp.push_back(NUMBERS_ops[j]);
-				str_tmp.push_back(str[j]);
-			}
-			
-			NUMBERS_ops = tmp;
-			str = str_tmp;
-			i = 0;
+// ------------------------------------------------------------------------------------------------
+// Command line options:
+//		--engine rpn	search permutations of RPN (default)
+//		--engine dp		subset dynamic programming solver, can prove when there is no solution
+//		--nearest		when there is no solution give the closest result found (within 10)
+//		--ranking file	search ranking to load (default ranking.txt)
+//		--train n		build the search ranking from n random games and write it to the ranking file
+//		--deadline s	seconds allowed to solve each game (default 30)
+//		--tiles n		numbers in a game (default 6, up to MAX_TILES), games of other sizes use the dp solver
+//		--targets a-b	range of the targets drawn or entered (default 101-999)
+//		--batch file	solve every game in file (- for standard input) without any interaction
+//		--format f		batch results as csv (default) or jsonl
+//		--notation n	solutions written as infix (default), rpn or json
+//		--output file	write batch results to file rather than standard output
+//		--all			write every distinct solution of each batch game rather than the first found
+//		--build-db file	solve every standard game with the dp solver and write the solution database to file
+//		--processes n	with --build-db, solve in n worker processes checkpointing to file.parts/ (a build
+//						that is stopped carries on from there when run again)
+//		--db file		look games up in the solution database before searching
+//		--cache-mb n	memory allowed for remembering results of games already solved (default 16, 0 for none)
+//		--serve addr	answer games sent to addr (unix:path or a loopback tcp port), see Server.h
+//		--client addr	send every game on standard input to the server at addr and print the answers
+//		--metrics file	write the solver's counters to file (JSON if it ends in .json, otherwise Prometheus
+//						text) when finished, or every 10 seconds while serving
+int main(int argc, char* argv[]) 
+{
+	SolverOptions options;
+	std::string batch, format = "csv", notation = "infix", output, build_file, serve, client, metrics;
+	std::string usage = std::string("Usage: ") + argv[0] + " [--engine rpn|dp] [--nearest] [--ranking file] [--train n] [--deadline s] [--tiles n] [--targets a-b]"
+		+ " [--batch file [--format csv|jsonl] [--output file] [--all]] [--notation infix|rpn|json] [--build-db file [--processes n]] [--db file] [--cache-mb n] [--serve addr] [--client addr] [--metrics file]";
+	int train = 0, tiles = 6, target_min = 101, target_max = 999;
+	double deadline = 30;
+	bool all = false;
+	int processes = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--engine" && i + 1 < argc) { options.engine = argv[++i]; }
+		else if (arg == "--nearest") { options.nearest = true; }
+		else if (arg == "--ranking" && i + 1 < argc) { options.ranking_file = argv[++i]; }
+		else if (arg == "--train" && i + 1 < argc) { train = std::atoi(argv[++i]); }
+		else if (arg == "--deadline" && i + 1 < argc) { deadline = std::atof(argv[++i]); }
+		else if (arg == "--tiles" && i + 1 < argc) { tiles = std::atoi(argv[++i]); }
+		else if (arg == "--targets" && i + 1 < argc)
+		{
+			std::string range = argv[++i];
+			size_t dash = range.find('-');
+			target_min = std::atoi(range.substr(0, dash).c_str());
+			target_max = (dash == std::string::npos) ? 0 : std::atoi(range.substr(dash + 1).c_str());
 		}
-		//std::cout << NUMBERS_ops.size() << std::endl;
-		//Display_stdvector_str(NUMBERS_ops);cout << soln << endl;
-		// Check if the running total is equal to the target
-		if (tot_curr == Target)
-		{
-			for (int p = 0; p < NUMBERS_ops.size(); p++)
+		else if (arg == "--batch" && i + 1 < argc) { batch = argv[++i]; }
+		else if (arg == "--format" && i + 1 < argc) { format = argv[++i]; }
+		else if (arg == "--notation" && i + 1 < argc) { notation = argv[++i]; }
+		else if (arg == "--output" && i + 1 < argc) { output = argv[++i]; }
+		else if (arg == "--all") { all = true; }
+		else if (arg == "--build-db" && i + 1 < argc) { build_file = argv[++i]; }
+		else if (arg == "--processes" && i + 1 < argc) { processes = std::atoi(argv[++i]); }
+		else if (arg == "--db" && i + 1 < argc) { options.db_file = argv[++i]; }
+		else if (arg == "--serve" && i + 1 < argc) { serve = argv[++i]; }
+		else if (arg == "--client" && i + 1 < argc) { client = argv[++i]; }
+		else if (arg == "--metrics" && i + 1 < argc) { metrics = argv[++i]; }
+		else if (arg == "--cache-mb" && i + 1 < argc)
+		{
+			const char* mb_str = argv[++i];
+			char* end;
+			double mb = std::strtod(mb_str, &end);
+			if (end == mb_str || *end != '\0' || !(mb >= 0 && mb <= (1 << 20)))
 			{
-				if (NUMBERS_ops[p] == "+") { continue; }
-				else if (NUMBERS_ops[p] == "*") { continue; }
-				else if (NUMBERS_ops[p] == "-") { continue; }
-				else if (NUMBERS_ops[p] == "/") { continue; }
-				else if (tot_curr == std::stoi(NUMBERS_ops[p])) { soln=p; }
+				std::cout << "Expected a cache size in MB from 0 to " << (1 << 20) << ", not " << mb_str << "\n" << usage << std::endl;
+				return 1;
 			}
-			if (NUMBERS_ops.size() == 1) {  soln = 0; } //cout << NUMBERS_ops.size() << endl;
-			return_str = NUMBERS_ops[soln] + " = " + str[soln]; //cout << return_str << endl;
-			return return_str;
+			options.cache_bytes = (size_t)(mb * (1 << 20));
 		}
+		else { std::cout << "Unknown option " << arg << "\n" << usage << std::endl; return 1; }
 	}
-	soln = 0;
-	return_str = NUMBERS_ops[soln] + " = " + str[soln];
-	return return_str;
-}
-
-// A function that takes a string of operations and returns a vector of vectors. 
-// - Vectors are comprised of distinct permutations of the operations (in accordance with how the vectors will be permuted)
-std::vector<std::vector<std::string>> makeCombn_operations(std::string v)
-{
-	std::vector<std::string> ops = { "+","*","-","/" }, vec(5);
-	for (int i = 0; i < v.length(); i++)
+	if (options.engine != "rpn" && options.engine != "dp") { std::cout << "Unknown engine " << options.engine << " (expected rpn or dp)" << std::endl; return 1; }
+	if (format != "csv" && format != "jsonl") { std::cout << "Unknown format " << format << " (expected csv or jsonl)" << std::endl; return 1; }
+	if (notation != "infix" && notation != "rpn" && notation != "json") { std::cout << "Unknown notation " << notation << " (expected infix, rpn or json)" << std::endl; return 1; }
+	if (tiles < 1 || tiles > MAX_TILES) { std::cout << "Expected between 1 and " << MAX_TILES << " tiles" << std::endl; return 1; }
+	if (target_min < 1 || target_max < target_min) { std::cout << "Expected a range of targets such as 101-999" << std::endl; return 1; }
+	if (train > 0)
+	{
+		train_ranking(train, options.ranking_file, 2021);
+		return 0;
+	}
+	if (!client.empty()) { return run_client(client, std::cin, std::cout); }
+	if (!build_file.empty())
 	{
-		if (v.substr(i, 1) == "+") { vec[i] = "+"; }
-		else if (v.substr(i, 1) == "*") { vec[i] = "*"; }
-		else if (v.substr(i, 1) == "-") { vec[i] = "-"; }
-		else if (v.substr(i,1)=="/") { vec[i] = "/"; }
-	}
-	// Now make the combinations
-	std::vector<std::vector<std::string>> Return_vec;
-	std::vector<std::vector<int>> OPs_combn = makeCombi(5, 4); //std::vector<std::vector<std::string>> OPs_combinations;
-	for (int i = 0; i < OPs_combn.size(); i++)
+		bool built = (processes > 0) ? build_db_sharded(build_file, processes) : build_db(build_file);
+		if (!built) { std::cerr << "Could not write " << build_file << std::endl; return 1; }
+		return 0;
+	}
+	Solver solver(options);
+	if (!solver.has_db()) { std::cerr << "Could not open solution database " << options.db_file << std::endl; return 1; }
+	if (!serve.empty())
 	{
-		std::vector<std::string> tmp;
-		// -------------------------------------------------------
-		std::vector<int> indexs = { 0,1,2,3,4 };
-		for (int k = 0; k < OPs_combn[i].size(); k++)
+		if (!metrics.empty())
 		{
-			for (int p = 0; p < indexs.size(); p++)
+			std::thread([&solver, metrics]()
 			{
-				if (OPs_combn[i][k] == indexs[p] + 1)
+				while (true)
 				{
-					indexs.erase(indexs.begin() + p);
+					std::this_thread::sleep_for(std::chrono::seconds(10));
+					write_metrics(metrics, solver);
 				}
-			}
-		}//display_stdvector(indexs);
-		for (int j = 0; j < OPs_combn[i].size(); j++)
-		{
-			tmp.push_back(vec[OPs_combn[i][j] - 1]);
+			}).detach();
 		}
-		tmp.push_back(vec[indexs[0]]); //Display_stdvector_str(tmp);
-		// Test tmp to see if it is a repeat of any other vectors already added
-		bool bl = false; // This boolean variable will turn true if we have a repeat
-		if (Return_vec.empty() == false)
-		{
-			// Check the tmp vector created 
-			int Add = 0, Sub = 0, Mul = 0, Div = 0;
-			for (int j = 0; j < tmp.size() - 1; j++)
-			{
-				if (tmp[j] == "+") { Add++; }
-				else if (tmp[j] == "-") { Sub++; }
-				else if (tmp[j] == "*") { Mul++; }
-				else { Div++; }
-			}
-			// Now loop over OPs_combinations to see if there are repeats of the tmp vector just created			
-			for (int k = 0; k < Return_vec.size(); k++)
-			{
-				int Add_ = 0, Sub_ = 0, Mul_ = 0, Div_ = 0;
-				for (int j = 0; j < Return_vec[k].size() - 1; j++)
-				{
-					if (Return_vec[k][j] == "+") { Add_++; }
-					else if (Return_vec[k][j] == "-") { Sub_++; }
-					else if (Return_vec[k][j] == "*") { Mul_++; }
-					else { Div_++; }
-				}
-				// Now checking if we have a repeat					
-				if (Add_ == Add)
-				{
-					if (Sub_ == Sub)
-					{
-						if (Mul_ == Mul)
-						{
-							if (Div_ == Div)
-							{// Found a repeat ==> don't add it
-								bl = true;
-							}
-						}
-					}
-				}
-			}
-		}
-		if (bl == false) { Return_vec.push_back(tmp); }
+		return run_server(serve, solver, deadline);
 	}
-	return Return_vec;
-}
-
-// ------------------------------------------------------------------------------------------------
-// This functions serves to create the solution when it is found by the program
-std::string Ans(std::vector<std::string> v, std::vector<int> Permutations_i, int T)
-{					// Numbers and operations		one of the permutations		Target
-	std::string str;
-	std::vector<string> v2 = { v[0],v[1] }; 
-	for (int i = 0; i < Permutations_i.size(); i++)
-	{
-		v2.push_back(v[Permutations_i[i]]);
-	}
-	//Display_stdvector_str(v2);
-	str = combn_solv(v2, T);
-	//cout << str;
-	return str;
-}
-// ------------------------------------------------------------------------------------------------
-// A function that runs through combinations
-std::string eval_(std::vector<std::string>& v, std::vector<std::vector<int>> &Permutations, int &T)
-{					// Numbers and operations			all 24192 permutations			Target
-	// -------------------------------------
-	for (int i = 0; i < Permutations.size(); i++)
+	if (!batch.empty())
 	{
-		// while loop to evaluate the vector of numbers and operations		
-		// Variable initialisation
-		std::vector<int> v6 = { std::stoi(v[0]),std::stoi(v[1]) }; 
-		int no_ops = 0, m = 0, tot_curr = 0, ind_ = 1;
-		while (no_ops < 5)
+		std::ifstream file;
+		std::ofstream out_file;
+		if (batch != "-")
 		{
-			if (v[Permutations[i][m]] == "+")
-			{
-				tot_curr = v6[ind_] + v6[ind_ - 1]; // possible optimization, do we need the tot_curr vector?
-				v6[ind_ - 1] = tot_curr;
-				v6.erase(v6.begin() + ind_);
-				no_ops++; ind_ = v6.size() - 1;
-			}
-			else if (v[Permutations[i][m]] == "*")
-			{
-				if (v6[ind_] == 1 || v6[ind_ - 1] == 1) { break; } // No benefit to multiplying by 1
-				else { tot_curr = v6[ind_ - 1] * v6[ind_]; }
-				v6[ind_ - 1] = tot_curr;
-				v6.erase(v6.begin() + ind_);
-				no_ops++; ind_ = v6.size() - 1;
-			}
-			else if (v[Permutations[i][m]] == "-")
-			{
-				// Check
-				if (v6[ind_ - 1] - v6[ind_] <= 0) { break; }
-				else if (v6[ind_ - 1] - v6[ind_] == v6[ind_]) { break; } // a-b=b (e.g. 10-5=5) worthless calculation
-				else { tot_curr = v6[ind_ - 1] - v6[ind_]; }
-				v6[ind_ - 1] = tot_curr;
-				v6.erase(v6.begin() + ind_);
-				no_ops++; ind_ = v6.size() - 1;
-			}
-			else if (v[Permutations[i][m]] == "/")
-			{
-				// Check cout << "here" << endl;
-				if ((v6[ind_ - 1] / v6[ind_]) * v6[ind_] != v6[ind_ - 1]) { break; }
-				else if (v6[ind_ - 1] / v6[ind_] == v6[ind_]) { break; } // Worthless computation when a/b=b (25/5=5)
-				else if (v6[ind_] == 1) { break; } // No benefit in dividing by 1
-				else { tot_curr = v6[ind_ - 1] / v6[ind_]; }
-				v6[ind_ - 1] = tot_curr;
-				v6.erase(v6.begin() + ind_);
-				no_ops++; ind_ = v6.size() - 1;
-			}
-			else { v6.push_back(std::stoi(v[Permutations[i][m]])); ind_++; }
-			if (tot_curr == T) { return Ans(v, Permutations[i], T); }
-			m++; //display_stdvector(v6);
+			file.open(batch);
+			if (!file) { std::cerr << "Could not open " << batch << std::endl; return 1; }
+		}
+		if (!output.empty())
+		{
+			out_file.open(output);
+			if (!out_file) { std::cerr << "Could not open " << output << std::endl; return 1; }
 		}
+		int rc = run_batch(batch == "-" ? std::cin : file, output.empty() ? std::cout : out_file, format, notation, solver, deadline, all);
+		if (!metrics.empty() && !write_metrics(metrics, solver)) { std::cerr << "Could not write " << metrics << std::endl; }
+		return rc;
 	}
-	// -------------------------------------std::cout << "here\n";
-	return "0";
-}
-
-int main() 
-{
 	// -----------==================================----------------
 	// =======================    Game    ==========================
 	// -----------==================================----------------
@@ -468,65 +493,6 @@ int main()
 	std::cout << "        " + line+line+line+line << std::endl;
 	std::cout << "        ================================================================================" << "\n\n" << std::endl;
 	// 
-	// ----------  This section of the code calculates all the permutations of five operations  --------------
-	std::vector<std::string> ops = { "+","*","/","-" };
-	std::vector<std::string> ops_perm;
-	ops_perm.resize(1024);
-	for (int i = 0, pos_1 = 0, pos_2 = 0, pos_3 = 0, pos_4 = 0; i < pow(4, 5); i++)
-	{
-		if (i % 4 == 0)
-		{
-			pos_1 = i / 4;
-			if (i % 16 == 0) { pos_2++; }
-			if (i % 64 == 0) { pos_3++; }
-			if (i % 256 == 0) { pos_4++; }
-		}
-		ops_perm[i] = ops[pos_4 - 1] + ops[pos_3 - 1 - (pos_4 - 1) * 4] + ops[pos_2 - 1 - (pos_3 - 1) * 4] + ops[pos_1 - (pos_2 - 1) * 4] + ops[i - pos_1 * 4];
-	}
-	// Obtain a vector of distinct set of operations
-	std::vector<std::string> opers;
-	for (int pos = 0; pos < ops_perm.size(); pos++)
-	{
-		std::string str = ops_perm[pos];
-		//std::cout << str << "\n" << std::endl;
-		int plus = 0, div = 0, times = 0, minus = 0;
-		for (int i = 0; i < str.size(); i++)
-		{
-			std::string op = str.substr(i, 1);
-			//std::cout << op << std::endl;
-			if (op == "+") { plus++; }
-			else if (op == "/") { div++; }
-			else if (op == "*") { times++; }
-			else if (op == "-") { minus++; }
-		}
-		for (int j = pos + 1; j < ops_perm.size(); j++)
-		{
-			int plus_ = 0, div_ = 0, times_ = 0, minus_ = 0;
-			std::string str_ = ops_perm[j];
-			for (int p = 0; p < str_.size(); p++)
-			{
-				std::string op_ = str_.substr(p, 1);
-				if (op_ == "+") { plus_++; }
-				else if (op_ == "/") { div_++; }
-				else if (op_ == "*") { times_++; }
-				else if (op_ == "-") { minus_++; }
-			}
-			if (plus_ == plus && div_ == div && times_ == times && minus_ == minus)
-			{
-				//std::cout << j << std::endl;
-				//ops_perm.erase(ops_perm.begin() + j);
-				ops_perm[j] = "0";
-			}
-		}
-	}
-	//std::cout << ops_perm.size() << std::endl;
-	for (int m = 0; m < ops_perm.size(); m++)
-	{
-		if (ops_perm[m] != "0")
-		{
-			opers.push_back(ops_perm[m]);
-		}
-	}
 	// 
 	// Press enter or specified key to start game
 	MVector LargeNumbers = { 25, 50, 75, 100 };
@@ -539,29 +505,28 @@ int main()
 	std::cout << "        ================================================================================" << "\n"<< std::endl;
 	// Interaction w/ user defining how many from each set
 	std::vector<int> NUMBERS;
-	int small, large, k=1, p=1, tot=6;
+	int large, k=1, p=1, max_large = std::min(4, tiles);
 	std::cout << "        How many numbers large numbers would you like?\n";
-	std::cout << "        Please enter a number between 0 and 4, or if you\n        would like to enter your own numbers type -1: ";
+	std::cout << "        Please enter a number between 0 and " << max_large << ", or if you\n        would like to enter your own numbers type -1: ";
 	std::cin >> large;
 	if (large != -1)
 	{
 		while (k == 1)
 		{
-			if (large > 4 || large < 0)
+			if (large > max_large || large < 0)
 			{
 				std::cout << "     \nPlease enter how many numbers you would like from the large number set: ";
 				std::cin >> large;
 			}
-			else if (large <= 4 && large >= 0)
+			else if (large <= max_large && large >= 0)
 			{
 				k = 0;
-				small = tot - large;
 			}
 		}
 	}
 	else
 	{
-		int num_tot = 6;
+		int num_tot = tiles;
 		while (num_tot > 0)
 		{
 			int num_input;
@@ -573,194 +538,15 @@ int main()
 	}
 	//std::cout << opers.size() << std::endl;
 	// --------------------   Numbers are randomly chosen here  -------------------------
-	int j = 0; std::vector<int> LargeNumbers_temp = {25,50,75,100};
 	if (large != -1)
 	{
-		while (j < large)
-		{
-			std::random_device rd;
-			std::mt19937 gen(rd());
-			std::uniform_int_distribution<> distr(0, LargeNumbers_temp.size() - 1); int a = distr(gen);
-			NUMBERS.push_back(LargeNumbers_temp[a]);
-			LargeNumbers_temp.erase(LargeNumbers_temp.begin() + a);
-			j++;
-		}
-		int i = 0; std::vector<int> SmallNumbers_temp = { 1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10 };
-		while (i < small)
-		{
-			std::random_device rd;
-			std::mt19937 gen(rd());
-			std::uniform_int_distribution<> distr(0, SmallNumbers_temp.size() - 1); int b = distr(gen);
-			NUMBERS.push_back(SmallNumbers_temp[b]);
-			SmallNumbers_temp.erase(SmallNumbers_temp.begin() + b);
-			i++;
-		}
+		std::random_device rd;
+		std::mt19937 gen(rd());
+		NUMBERS = random_draw(large, gen, tiles);
 	}
 	// FOR TESTING PURPOSES ONLY
 	//NUMBERS = { 25,8,10,7,1,5 };
-	// ==========================================================================================
-	// --------------------------  Generating VALID RPN notation  -------------------------------
-	// ==========================================================================================
-	std::vector<std::string> N_ops = { "N","N", "N", "N", "N", "N", "op","op","op","op","op" };
-	// Code that chooses distinct set of 4 from 8 in this case
-	vector<vector<int>> permns_tmp = makeCombi(8, 4), permns;
-	// Checking
-	std::vector<int> ind;
-	for (int p = 0; p < permns_tmp.size(); p++)
-	{
-		std::vector<int> vec_tmp = permns_tmp[p];
-		std::vector<std::string> v1;
-		for (int i = 0; i < vec_tmp.size(); i++)
-		{
-			v1.push_back(N_ops[vec_tmp[i] + 1]);
-		}
-		// Check validity of RPN
-		int N = 2, op = 0;
-		for (int j = 0; j < v1.size(); j++)
-		{
-			if (v1[j] == "N") { N++; }
-			else { op++; }
-			if (N == op)
-			{
-				ind.push_back(p); //Display_stdvector_str(v1);//permns_tmp.erase(permns_tmp.begin() + p);
-			}
-		}
-	}//std::cout << "\n\n" << permns_tmp.size() << std::endl;
-	for (int t = ind.size() - 1; t > 0; t--)
-	{
-		permns_tmp.erase(permns_tmp.begin() + ind[t]);
-	}//std::cout << "\n\n" << permns_tmp.size() << std::endl;
-	// Add the permutations of each of the permutations
-	std::vector<int> v_tmp = { 0,1,2,3 }; int u = 0;
-	for (int j = 0; j < permns_tmp.size(); j++)
-	{
-		std::vector<int> tmp = permns_tmp[j];
-		// Create permutations for each vector
-		do
-		{
-			bool b = true;
-			std::vector<int> tmpp;
-			for (int e : v_tmp) { tmpp.push_back(tmp[e]); }
-			// Check the validity of the permutation
-			std::vector<std::string> v1;
-			for (int i = 0; i < tmpp.size(); i++)
-			{
-				v1.push_back(N_ops[tmpp[i] + 1]);
-			}
-			//Display_stdvector_str(v1);
-			int N = 2, op = 0;
-			for (int j = 0; j < v1.size(); j++)
-			{
-				if (v1[j] == "N") { N++; }
-				else { op++; }
-				if (N == op)
-				{
-					u++; b = false;//Display_stdvector_str(v1);//break;
-				}//else {  }
-			}
-			if (b == true)
-			{
-				permns.push_back(tmpp);	//Display_stdvector_str(v1);
-			}
-		} while (std::next_permutation(v_tmp.begin(), v_tmp.end()));
-	}
-	// -----------------------------------------------------------------------------------------
-	//cout << permns.size() << endl;
-	//cout << u << endl;
-	// Creating the permutations of 8 
-	std::vector<std::vector<int>> Permutations;
-	for (int p = 0; p < permns.size(); p++)
-	{
-		// Calculate the valid permutations for eight 
-		std::vector<int> v2 = permns[p], pos = { 1,2,3,4,5,6,7,8 }, pos_remaining; int N_ = 2, op_ = 0;
-		for (int j = 0; j < v2.size(); j++)
-		{
-			if (N_ops[v2[j] + 1] == "N") { N_++; }
-			else { op_++; }
-			for (int k = 0; k < pos.size(); k++)
-			{
-				if (pos[k] == v2[j]) { pos[k] = -1; }
-			}
-		}
-		for (int i = 0; i < pos.size(); i++)
-		{
-			if (pos[i] != -1) { pos_remaining.push_back(pos[i]); }
-		}
-		// -------------------------------------------------------
-		// Run a do while loop to permute the 4 remaining positions
-		do
-		{
-			std::vector<int> v3 = v2;
-			for (int e : v_tmp)
-			{
-				v3.push_back(pos_remaining[e]);
-			}
-			// Initialise and check
-			int No = N_, Op = op_; bool B = true;
-			for (int k = 0; k < v3.size(); k++)
-			{
-				if (N_ops[v3[k] + 1] == "N") { No++; }
-				else { Op++; }
-				if (No == Op) { B = false; }
-			}
-			if (B == true) { v3.push_back(9); Permutations.push_back(v3); }
-		} while (next_permutation(v_tmp.begin(), v_tmp.end()));
-	}
-	// cout << Permutations.size() << endl;
-	//
-	for (int i = 0; i < Permutations.size(); i++)
-	{
-		for (int j = 0; j < Permutations[i].size(); j++)
-		{
-			Permutations[i][j]++;
-		}
-	}
 	// ---------------------------------------------------------------------------------------------------------
-	// Code that calculates permutations of numbers and operations
-	std::vector<std::vector<int>> Numbers_combn = makeCombi(NUMBERS.size(), 2);
-	// Note: does not account for repeats, 15 vectors produced
-	// To be run at the beginning of the game, does not need to be run during finding solutions
-	for (int p = 0; p < Numbers_combn.size(); p++)
-	{
-		// Combinations already made above
-		//std::vector<int> n_tmp = NUMBERS;
-		std::vector<int> positions = { 0,1,2,3,4,5 };
-		for (int k = 0; k < Numbers_combn[p].size(); k++)
-		{
-			// Replace with number values
-			Numbers_combn[p][k] = Numbers_combn[p][k]-1;
-			for (int j = 0; j < positions.size(); j++)
-			{
-				if (positions[j] == Numbers_combn[p][k]) { positions.erase(positions.begin() + j); }
-			}
-			/*
-			Numbers_combn[p][k] = NUMBERS[Numbers_combn[p][k] - 1];
-			for (int j = 0; j < n_tmp.size(); j++)
-			{
-				if (Numbers_combn[p][k] == n_tmp[j]) { n_tmp.erase(n_tmp.begin() + j); }
-			}
-			*/
-		}	
-		Numbers_combn[p][0] = NUMBERS[Numbers_combn[p][0]];
-		Numbers_combn[p][1] = NUMBERS[Numbers_combn[p][1]];
-		for (int y = 0; y < positions.size(); y++)
-		{
-			Numbers_combn[p].push_back(NUMBERS[positions[y]]);
-		}
-		//display_stdvector(Numbers_combn[p]);
-	}
-	// Turn to strings ready for computation
-	std::vector<std::vector<std::string>> Numbers_combn_str(Numbers_combn.size());
-	for (int i = 0; i < Numbers_combn.size(); i++)
-	{
-		std::vector<string> tmp(Numbers_combn[i].size());
-		for (int k = 0; k < Numbers_combn[i].size(); k++)
-		{
-			tmp[k] = std::to_string(Numbers_combn[i][k]);
-		}
-		Numbers_combn_str[i] = tmp;
-		//Display_stdvector_str(tmp);
-	}
 	/* Now we display the numbers to the user we randomly generated from the sets of large numbers and small numbers
 	* and randomly generate a number that will be our target. 
 	*/
@@ -768,7 +554,7 @@ int main()
 	int T = 0;
 	if (large == -1)
 	{
-		while (T < 101 || T > 999)
+		while (T < target_min || T > target_max)
 		{
 			std::cout << "\n        Please enter a target number: ";
 			std::cin >> T;
@@ -802,7 +588,7 @@ int main()
 	std::cout << "\n" << std::endl;
 	std::random_device rd;
 	std::mt19937 gen(rd());
-	std::uniform_int_distribution<> distr(101,999);
+	std::uniform_int_distribution<> distr(target_min, target_max);
 	int Target; 	
 	if (large == -1) { Target = T; }
 	else { Target = distr(gen); }
@@ -810,193 +596,44 @@ int main()
 	//Target = 988;
 	// ---------------
 	std::cout << "               TARGET :                        " << Target << "\n\n";
-	// Begin countdown from 30 and call countdown solver fn
-	// =========================================================
-	// IMPORTANT data: 
-	/*		- Vector of Permutations - Permutations
-			- Vector of distinct operations - opers
-			- Vector of distinct Numbers - Numbers_combn
-	*/
-	// =========================================================
-	/*
-	for (int l = 0; l < opers.size(); l++)
+	std::cout << "                                           - Working - ";
+	GameResult res = solver.solve(NUMBERS, Target, deadline);
+	std::cout << "\b\b\b\b\b\b\b\b\b\b\b\b\n" << std::endl;
+	if (res.status == SOLVED) 
 	{
-		//Display_stdvector_str(NUMBERS_opers[l]);
-		cout << opers[l] << endl;
+		std::cout << "\n                                 ------- SOLUTION FOUND! -------     \n\n";
 	}
-	*/
-	//std::cout << "=============\n";
-	//std::cout << opers.size() << std::endl;
-	/* ---------------------------------------------------------------------------------------------------
-	This section of code rearranges the list of permutations of 5 operations so that 
-	the sets of operations which are most likely to make a solution are used first in a search.
-		-	We only add sets of permutations to the list if * is one of the operations
-		-	We only add sets of permutations if they have a good variety of operations
-		   --> dicated by the size of makeCombn_operations vector; large vector ==> lots of variety
-
-	We have already worked out the different permutations of five operations for the six numbers we
-	we are required to use to solve the game. In the next loop the sets of operations are rearranged 
-	so that the most "useful" sets are used first in the search for a solution. For example the set
-	(////-) is pretty much useless in finding a solution to the numbers game, whereas (*++-/) is 
-	probably much more likely to yield answers near the target number. The code here evaluates the 
-	importance of a given set of permutations and adds it to the list it will search through in 
-	finding a solution, otherwise it is not added. 
-
-	This could be made adaptable for different number sets, e.g. more * if we have smaller numbers 
-	in order to achieve larger numbers. Certainly +, *  are used nearly everytime, whereas - and /
-	see less frequent use. 
-	*/
-	std::vector<std::string> opers_tmp;
-	for (int k = 0; k < 5; k++)
+	else if (res.status == NEAREST && res.exhaustive)
 	{
-		for (int i = 0; i < opers.size(); i++)	
-		{
-			if (makeCombn_operations(opers[i]).size() == 5 - k) 
-			{ 
-				int addn = 0, subn = 0, muln = 0, divn = 0;
-				for (int j = 0; j < makeCombn_operations(opers[i]).size(); j++)
-				{
-					
-					for (int l = 0; l < makeCombn_operations(opers[i])[j].size(); l++)
-					{
-						// Prescribing conditions desirable for a set of operations
-						if (makeCombn_operations(opers[i])[j][l] == "*")
-						{
-							muln++;
-							//opers_tmp.push_back(opers[i]);
-						}
-						else if (makeCombn_operations(opers[i])[j][l] == "+") { addn++; }
-						else if (makeCombn_operations(opers[i])[j][l] == "-") { subn++; }
-						else { divn++; }
-					}				
-					// To add or not to add to the search space
-					if (muln >= 1 && muln <= 3 && divn <= 2 && addn <= 3 && subn <= 2)
-					{
-						opers_tmp.push_back(opers[i]);
-					}
-				}
-
-			}
-		}
+		std::cout << "\n                   ------- No solution exists, the closest is " << res.distance << " away -------     \n\n";
 	}
-	opers = opers_tmp;
-	// This creates 13 strings ...
-	/*
-	std::cout << "=============\n";
-	for (int l = 0; l < opers.size(); l++)
+	else if (res.status == NEAREST)
 	{
-		//Display_stdvector_str(NUMBERS_opers[l]);
-		cout << opers[l] << endl;
-	}*/
-	//std::cout << opers.size() << std::endl;
-	/*
-										|
-										|
-										|
-				NEED TO CREATE WHAT WE WILL ITERATE OVER -->HERE<--
-				AND GET READY TO CALCULATE AS FAST AS POSSIBLE!!!!
-										|
-										|
-										|
-		- Create a big loop to loop over all possible combinations, with the ability to break out of all of it.
-		- Test on a given set of operations (e.g. "+-+*-+") first, but still create all data required to do full search. 
-		- Make optimizations where possible.
-
-
-	Now we iterate over the permutations we have created in the search for a solution, this is
-	where multi-threading is employed to increase performance in obtaining a solution. If a solution
-	is not found the loop ends after approximately 30 seconds, otherwise the we break out of the loop
-	searching for the solution and the solution is displayed to the user.
-	*/
-	// This is pretty fast!
-	// Could it be faster?
-	double combns = 0;
-	std::string strng = "0"; std::cout << "                                           ";
-	auto start1 = std::chrono::steady_clock::now();
-	int t = 0;
-	for (auto start = std::chrono::steady_clock::now(), now = start; now < start + std::chrono::seconds{ 30 }; now = std::chrono::steady_clock::now())
-	{
-		// Initialising data
-		
-		std::vector<std::vector<std::string>> Ops_perm = makeCombn_operations(opers[t]), Num_vec;
-		// Creates the vectors we will iterate over; this will be a multiple of 15
-		for (int i = 0; i < Numbers_combn_str.size(); i++)
-		{
-			for (int j = 0; j < Ops_perm.size(); j++)
-			{
-				//Display_stdvector_str(Ops_perm[j]);
-				std::vector<std::string> tempry = Numbers_combn_str[i];
-				for (int k = 0; k < Ops_perm[j].size(); k++)
-				{
-					tempry.push_back(Ops_perm[j][k]);
-					//cout << Ops_perm[j][k] << endl;
-				}
-				Num_vec.push_back(tempry);	
-			}
-		}
-		/*
-		auto start2 = std::chrono::steady_clock::now();
-		std::string strng_ = eval_(Num_vec[0], Permutations, T);
-		auto end2 = std::chrono::steady_clock::now(); auto time2_diff = end2 - start2;
-		std::cout << "\n                                Time taken: " << std::chrono::duration<double, std::milli>(time2_diff).count() << " milliseconds\n\n\n\n" << std::endl;
-		*/
-		/*
-		for (int l = 0; l < Num_vec.size(); l++)
-		{
-			Display_stdvector_str(Num_vec[l]);
-		}*/
-		// Testing for solutions
-		//cout << opers[p] << endl;
-		std::string thd1 = "0", thd2 = "0", thd3 = "0", thd4 = "0", thd5 = "0";
-		int r = 0; 
-		for (int p = 0; p < Num_vec.size() / 5; p++)
-		{
-			if (r == 0) { std::cout << "\\ Working \\ "; r++; }
-			else if (r == 1) { std::cout << "/ Working / "; r++; }
-			else if (r == 2) { std::cout << "- Working - "; r = 0; }
-			std::thread t1{ [&]() { thd1 = eval_(Num_vec[5 * p], Permutations, Target); } };
-			std::thread t2{ [&]() { thd2 = eval_(Num_vec[5 * p + 1], Permutations, Target); } };
-			std::thread t3{ [&]() { thd3 = eval_(Num_vec[5 * p + 2], Permutations, Target);  } };
-			std::thread t4{ [&]() {	thd4 = eval_(Num_vec[5 * p + 3], Permutations, Target); } };
-			std::thread t5{ [&]() {	thd5 = eval_(Num_vec[5 * p + 4], Permutations, Target); } };
-			// ------------------------------------------------------
-			t1.join();
-			t2.join();
-			t3.join();
-			t4.join();
-			//Display_stdvector_str(Num_vec[5 * p + 4]);
-			t5.join();	//cout << Ops_perm.size() << endl;
-			if (thd1 != "0") { strng = thd1; break; }
-			if (thd2 != "0") { strng = thd2; break; }
-			if (thd3 != "0") { strng = thd3; break; }
-			if (thd4 != "0") { strng = thd4; break; }
-			if (thd5 != "0") { strng = thd5; break; }
-			std::cout << "\b\b\b\b\b\b\b\b\b\b\b\b";
-		}
-		combns = combns + 24192.0 *Num_vec.size();
-		if (strng != "0") { break; }
-		//if (p > 5) { break; }
-		t++;
-	}
-	auto end1 = std::chrono::steady_clock::now(); auto time1_diff = end1 - start1;
-	std::cout << "\b\b\b\b\b\b\b\b\b\b\b\n" << std::endl;
-	if (strng != "0") 
+		std::cout << "\n                   ------- No solution found, the closest is " << res.distance << " away -------     \n\n";
+	}
+	else if (res.status == NO_SOLUTION)
 	{
-		std::cout << "\n                                 ------- SOLUTION FOUND! -------     \n\n";
-		std::cout << "                    ---------------------------------------------------------   \n\n";
-		std::cout << "                           " + strng + "    \n\n";
-		std::cout << "                    ---------------------------------------------------------   \n\n\n";
+		std::cout << "                   There is no solution, nor anything within " << NEAREST_RANGE << " of the target.\n\n";
 	}
 	else {
 		std::cout << "                             A solution could not be found in time. :(\n\n";
 		std::cout << "                            It's possible the solution may not exist...\n";
 	}
+	if (res.solution.length > 0)
+	{
+		std::cout << "                    ---------------------------------------------------------   \n\n";
+		std::cout << "                           " + write_solution(res.solution, notation) + "    \n\n";
+		std::cout << "                    ---------------------------------------------------------   \n\n\n";
+	}
 	std::cout << "                         -------=================================-------     \n";
-	std::cout << "                         |    No. of combinations tried:  "<< combns << "  |" << std::endl;
+	if (res.from_db) { std::cout << "                         |    Answered from the solution database  |" << std::endl; }
+	else if (res.exhaustive) { std::cout << "                         |    No. of values made:  " << res.tried << "  |" << std::endl; }
+	else { std::cout << "                         |    No. of combinations tried:  " << (double)res.tried << "  |" << std::endl; }
 	std::cout << "                         -------=================================-------     \n\n";
 	
-	std::cout << "\n                                Time taken: " << std::chrono::duration<double, std::milli>(time1_diff).count() << " milliseconds\n\n\n\n" << std::endl;
+	std::cout << "\n                                Time taken: " << res.ms << " milliseconds\n\n\n\n" << std::endl;
 
+	if (!metrics.empty() && !write_metrics(metrics, solver)) { std::cerr << "Could not write " << metrics << std::endl; }
 	// WHY does it take so long to check a vector where the solution cannot be found? Is it doing something unnecessary??
 	return 0;
-}
\ No newline at end of file
+}
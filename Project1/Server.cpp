@@ -0,0 +1,298 @@
+// =============================================================================================
+// **************************       Countdown numbers game server     **************************
+// =============================================================================================
+// See Server.h for the protocol. Every connection has a thread reading its requests, which are put
+// on one queue shared by all connections. A fixed set of request threads take requests from the
+// queue and solve them with the shared Solver (whose pool does the searching), writing each answer
+// back to its connection as soon as it is ready.
+#include "Server.h"
+#include<vector>
+#include<string>
+#include<sstream>
+#include<algorithm>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<deque>
+#include<memory>
+#include<cstring>
+#include<cstdlib>
+
+#ifdef _WIN32
+// Only Unix domain sockets and POSIX sockets are supported for now
+int run_server(const std::string& address, Solver& solver, double deadline)
+{
+	std::cerr << "Server mode is not available on Windows" << std::endl;
+	return 1;
+}
+int run_client(const std::string& address, std::istream& in, std::ostream& out)
+{
+	std::cerr << "Client mode is not available on Windows" << std::endl;
+	return 1;
+}
+#else
+#include<sys/socket.h>
+#include<sys/un.h>
+#include<netinet/in.h>
+#include<arpa/inet.h>
+#include<unistd.h>
+#include<signal.h>
+#include<cerrno>
+
+// Opens a socket for address (see Server.h), listening on it for the server or connected to it for
+// the client. Returns -1 on failure.
+int open_socket(const std::string& address, bool server)
+{
+	int fd = -1, ok = -1;
+	if (address.compare(0, 5, "unix:") == 0)
+	{
+		std::string path = address.substr(5);
+		sockaddr_un sa = {};
+		sa.sun_family = AF_UNIX;
+		if (path.empty() || path.size() >= sizeof(sa.sun_path)) { return -1; }
+		std::strcpy(sa.sun_path, path.c_str());
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0) { return -1; }
+		if (server)
+		{
+			unlink(path.c_str()); // left behind by a server that was stopped
+			ok = bind(fd, (sockaddr*)&sa, sizeof(sa));
+		}
+		else { ok = connect(fd, (sockaddr*)&sa, sizeof(sa)); }
+	}
+	else
+	{
+		std::string port_str = (address.compare(0, 4, "tcp:") == 0) ? address.substr(4) : address;
+		int port = std::atoi(port_str.c_str());
+		if (port <= 0 || port > 65535) { return -1; }
+		sockaddr_in sa = {};
+		sa.sin_family = AF_INET;
+		sa.sin_port = htons(port);
+		sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0) { return -1; }
+		if (server)
+		{
+			int on = 1;
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+			ok = bind(fd, (sockaddr*)&sa, sizeof(sa));
+		}
+		else { ok = connect(fd, (sockaddr*)&sa, sizeof(sa)); }
+	}
+	if (ok == 0 && server) { ok = listen(fd, 64); }
+	if (ok != 0) { close(fd); return -1; }
+	return fd;
+}
+
+// Writes all of str, returns false if the other end has gone
+bool send_all(int fd, const std::string& str)
+{
+	size_t done = 0;
+	while (done < str.size())
+	{
+		ssize_t n = send(fd, str.data() + done, str.size() - done, 0);
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n <= 0) { return false; }
+		done += n;
+	}
+	return true;
+}
+
+// Longest request line read, anything longer is not a game and closes the connection
+const size_t MAX_LINE = 4096;
+// Most requests of one connection being solved at once, its requests are not read meanwhile
+const int MAX_IN_FLIGHT = 64;
+
+// Reads lines from a socket, keeping whatever follows the last newline for the next call
+class LineReader
+{
+public:
+	explicit LineReader(int fd) : fd(fd) {}
+	// Returns false once the other end has finished sending
+	bool next(std::string& line)
+	{
+		while (true)
+		{
+			size_t end = buf.find('\n');
+			if (end != std::string::npos)
+			{
+				if (end > MAX_LINE) { return false; } // may have come in over several reads
+				line = buf.substr(0, end);
+				buf.erase(0, end + 1);
+				if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+				return true;
+			}
+			if (buf.size() > MAX_LINE) { return false; }
+			char chunk[4096];
+			ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+			if (n < 0 && errno == EINTR) { continue; }
+			if (n <= 0) { return false; }
+			buf.append(chunk, n);
+		}
+	}
+private:
+	int fd;
+	std::string buf;
+};
+
+// A connection is shared by the thread reading its requests and by its requests still being
+// solved, the socket is closed once all of them are done with it. A client sending requests without
+// reading the answers is held back by MAX_IN_FLIGHT, so the queue of requests cannot grow without
+// bound (the client's own writes then block).
+struct Connection
+{
+	int fd;
+	std::mutex m; // one answer written at a time
+	std::condition_variable cv;
+	int in_flight = 0; // requests read but not answered yet
+	explicit Connection(int fd) : fd(fd) {}
+	~Connection() { close(fd); }
+	void send_line(const std::string& line)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m);
+			send_all(fd, line + "\n");
+			in_flight--;
+		}
+		cv.notify_one();
+	}
+	// Waits until another request of the connection may be solved
+	void start_request()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait(lock, [this]() { return in_flight < MAX_IN_FLIGHT; });
+		in_flight++;
+	}
+};
+
+struct Request
+{
+	std::shared_ptr<Connection> conn;
+	std::string line;
+};
+class RequestQueue
+{
+public:
+	void push(Request r)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m);
+			requests.push_back(std::move(r));
+		}
+		cv.notify_one();
+	}
+	Request pop()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait(lock, [this]() { return !requests.empty(); });
+		Request r = std::move(requests.front());
+		requests.pop_front();
+		return r;
+	}
+private:
+	std::mutex m;
+	std::condition_variable cv;
+	std::deque<Request> requests;
+};
+
+// Solves one request line and returns the answer line
+std::string answer(const std::string& line, Solver& solver, double deadline)
+{
+	std::istringstream ss(line);
+	std::string id, word;
+	ss >> id;
+	std::vector<std::string> words;
+	while (ss >> word) { words.push_back(word); }
+	if (words.size() != 7 && words.size() != 8) { return id + " error expected six numbers, the target and optionally the deadline"; }
+	std::vector<int> v;
+	for (int k = 0; k < 7; k++)
+	{
+		char* end;
+		long x = std::strtol(words[k].c_str(), &end, 10);
+		if (*end != '\0' || x <= 0 || x > 1000000) { return id + " error bad number " + words[k]; }
+		v.push_back((int)x);
+	}
+	if (words.size() == 8)
+	{
+		char* end;
+		double requested = std::strtod(words[7].c_str(), &end);
+		if (*end != '\0' || !(requested > 0)) { return id + " error bad deadline " + words[7]; }
+		deadline = std::min(requested, deadline); // no longer than the server allows
+	}
+	GameResult res = solver.solve(std::vector<int>(v.begin(), v.begin() + 6), v[6], deadline);
+	std::ostringstream out;
+	out << id << " " << status_name(res.status) << " " << res.distance << " " << res.ms;
+	if (res.solution.length > 0) { out << " " << format_infix(res.solution); }
+	return out.str();
+}
+
+int run_server(const std::string& address, Solver& solver, double deadline)
+{
+	int fd = open_socket(address, true);
+	if (fd < 0) { std::cerr << "Could not listen on " << address << ": " << std::strerror(errno) << std::endl; return 1; }
+	signal(SIGPIPE, SIG_IGN); // a client going away must not stop the server
+	RequestQueue queue;
+	// Enough request threads that quick games are not held up behind a long search
+	int n = std::max(4, (int)std::thread::hardware_concurrency());
+	for (int i = 0; i < n; i++)
+	{
+		std::thread([&queue, &solver, deadline]()
+		{
+			while (true)
+			{
+				Request r = queue.pop();
+				r.conn->send_line(answer(r.line, solver, deadline));
+			}
+		}).detach();
+	}
+	std::cerr << "Listening on " << address << std::endl;
+	while (true)
+	{
+		int c = accept(fd, NULL, NULL);
+		if (c < 0)
+		{
+			if (errno != EINTR) { std::cerr << "accept: " << std::strerror(errno) << std::endl; }
+			continue;
+		}
+		auto conn = std::make_shared<Connection>(c);
+		std::thread([conn, &queue]()
+		{
+			LineReader reader(conn->fd);
+			std::string line;
+			while (reader.next(line))
+			{
+				if (line.find_first_not_of(" \t") == std::string::npos) { continue; }
+				conn->start_request();
+				queue.push({ conn, line });
+			}
+		}).detach();
+	}
+}
+
+int run_client(const std::string& address, std::istream& in, std::ostream& out)
+{
+	int fd = open_socket(address, false);
+	if (fd < 0) { std::cerr << "Could not connect to " << address << ": " << std::strerror(errno) << std::endl; return 1; }
+	signal(SIGPIPE, SIG_IGN);
+	// Every game is sent straight away, numbered from 1, while the answers are read back
+	std::thread writer([fd, &in]()
+	{
+		std::string line;
+		int game = 0;
+		while (std::getline(in, line))
+		{
+			std::replace(line.begin(), line.end(), ',', ' ');
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#') { continue; }
+			if (!send_all(fd, std::to_string(++game) + " " + line + "\n")) { break; }
+		}
+		shutdown(fd, SHUT_WR); // tells the server there are no more requests
+	});
+	LineReader reader(fd);
+	std::string line;
+	while (reader.next(line)) { out << line << std::endl; }
+	writer.join();
+	close(fd);
+	return 0;
+}
+#endif
@@ -0,0 +1,36 @@
+// =============================================================================================
+// **************************       Countdown numbers game server     **************************
+// =============================================================================================
+// Serves games to other programs over a local socket so the tables, threads, ranking and cache
+// of one Solver are shared by every request. The address is either unix:<path> for a Unix domain
+// socket or [tcp:]<port> for a TCP port on the loopback interface.
+//
+// The protocol is one line per message. A request is an id (any word without spaces) followed by
+// the six numbers, the target and optionally the deadline in seconds (at most the server's own,
+// which is also the deadline of requests without one):
+//
+//			7 25 8 10 7 1 5 988 30
+//
+// and every request is answered by a line starting with its id, followed by the status, the
+// distance from the target, the time taken in ms and the solution (which may contain spaces):
+//
+//			7 solved 0 2.81 988 = ((((25 * 8) - 1) * 5) - 7)
+//
+// or "<id> error <message>" for a request that cannot be read. Requests can be sent one after
+// another without waiting (pipelined), they are solved at the same time and answered as soon as
+// each one is done, so answers may come back in a different order to the requests. Up to 64
+// requests of a connection are solved at once, the rest are not read until answers have gone out.
+#ifndef SERVER_H
+#define SERVER_H
+
+#include<string>
+#include<iostream>
+#include "Solver/Solver.h"
+
+// Listens on address and answers requests until the process is stopped
+int run_server(const std::string& address, Solver& solver, double deadline);
+// Sends every game in in (one per line as for --batch) to the server at address without waiting
+// for answers, and writes the answers to out as they arrive
+int run_client(const std::string& address, std::istream& in, std::ostream& out);
+
+#endif
@@ -0,0 +1,2373 @@
+// =============================================================================================
+// **************************      Countdown numbers game solver     ***************************
+// =============================================================================================
+// The search engines behind the Solver class of Solver.h. See the summary at the top of 
+// Countdown.cpp for how the RPN search works.
+#include "Solver.h"
+#include<iostream>
+#include<cmath>
+#include<vector>
+#include<chrono>
+#include<fstream>
+#include<sstream>
+#include<string>
+#include<algorithm>
+#include<random>
+#include<thread>
+#include<cstring>
+#include<array>
+#include<atomic>
+#include<mutex>
+#include<condition_variable>
+#include<deque>
+#include<list>
+#include<functional>
+#include<memory>
+#include<unordered_map>
+#include<unordered_set>
+#include<cstdint>
+#include<limits>
+#include<cstdio>
+#ifdef _WIN32
+#define NOMINMAX
+#include<windows.h>
+#else
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<sys/wait.h>
+#include<sys/file.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<signal.h>
+#include<cerrno>
+#ifdef __linux__
+#include<sys/prctl.h>
+#endif
+#endif
+
+using namespace std;
+void makeCombn(vector<vector<int>>& ans, vector<int>& tmp, int n, int left, int k)
+{
+	if (k == 0)
+	{
+		ans.push_back(tmp);
+		return;
+	}
+	for (int i = left; i <= n; i++)
+	{
+		tmp.push_back(i);
+		makeCombn(ans, tmp, n, i + 1, k - 1);
+		tmp.pop_back();
+	}
+}
+
+vector<vector<int>> makeCombi(int n, int k)
+{
+	vector<vector<int>> ans;
+	vector<int> tmp;
+	makeCombn(ans, tmp, n, 1, k);
+	return ans;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Compiled games: rather than strings, each game is a fixed array of integer tokens. Numbers in the
+// game are always positive so they are stored as themselves, operations are stored as the negative 
+// opcodes below. Games are compiled once before the search so no parsing happens in eval_.
+enum Opcode { ADD = -1, MUL = -2, SUB = -3, DIV = -4 };
+typedef std::array<int, 11> Game;
+// Number of positions of a game that are permuted (the first two numbers are fixed)
+constexpr int PERM_LEN = 9;
+
+// Converts an operation character (+,*,-,/) into its opcode
+int opcode(char c)
+{
+	if (c == '+') { return ADD; }
+	else if (c == '*') { return MUL; }
+	else if (c == '-') { return SUB; }
+	else { return DIV; }
+}
+// Converts an opcode back into the symbol used when displaying a solution
+std::string op_symbol(int tok)
+{
+	if (tok == ADD) { return "+"; }
+	else if (tok == MUL) { return "*"; }
+	else if (tok == SUB) { return "-"; }
+	else { return "/"; }
+}
+// Builds a game from the six numbers (first two fixed) and five operations
+Game compile_game(const std::vector<int>& numbers, const std::int8_t* ops)
+{
+	Game g;
+	for (int i = 0; i < 6; i++) { g[i] = numbers[i]; }
+	for (int i = 0; i < 5; i++) { g[6 + i] = ops[i]; }
+	return g;
+}
+
+// Works out a op b
+long long apply_op(int op, long long a, long long b)
+{
+	if (op == ADD) { return a + b; }
+	else if (op == MUL) { return a * b; }
+	else if (op == SUB) { return a - b; }
+	else { return a / b; }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Solutions
+// Every engine hands back its solution as a SolutionTrace (see Solver.h), the tokens of the
+// expression in RPN, and it is only written out when asked for. Each operation is written with its
+// operands in the order they were made, e.g. 25 8 * 1 - is ((25 * 8) - 1).
+long long trace_value(const SolutionTrace& t)
+{
+	long long stack[2 * MAX_TILES - 1];
+	int top = 0;
+	for (int k = 0; k < t.length; k++)
+	{
+		if (t.tokens[k] >= 0) { stack[top++] = t.tokens[k]; continue; }
+		top--;
+		stack[top - 1] = apply_op(t.tokens[k], stack[top - 1], stack[top]);
+	}
+	return (top > 0) ? stack[top - 1] : 0;
+}
+
+std::string format_infix(const SolutionTrace& t)
+{
+	if (t.length == 0) { return "0"; }
+	std::vector<std::string> str;
+	for (int k = 0; k < t.length; k++)
+	{
+		if (t.tokens[k] >= 0) { str.push_back(std::to_string(t.tokens[k])); continue; }
+		std::string b = str.back();
+		str.pop_back();
+		str.back() = "(" + str.back() + " " + op_symbol(t.tokens[k]) + " " + b + ")";
+	}
+	return std::to_string(trace_value(t)) + " = " + str.back();
+}
+
+std::string format_rpn(const SolutionTrace& t)
+{
+	std::string out;
+	for (int k = 0; k < t.length; k++)
+	{
+		if (k > 0) { out += " "; }
+		out += (t.tokens[k] >= 0) ? std::to_string(t.tokens[k]) : op_symbol(t.tokens[k]);
+	}
+	return out;
+}
+
+std::string format_json(const SolutionTrace& t)
+{
+	if (t.length == 0) { return "null"; }
+	std::string out = "{\"value\":" + std::to_string(trace_value(t)) + ",\"rpn\":[";
+	for (int k = 0; k < t.length; k++)
+	{
+		if (k > 0) { out += ","; }
+		out += (t.tokens[k] >= 0) ? std::to_string(t.tokens[k]) : "\"" + op_symbol(t.tokens[k]) + "\"";
+	}
+	return out + "]}";
+}
+
+// The solution written so that reordering the operands of a sum or product gives the same text: runs
+// of + (or *) are flattened into one list of operands which is then sorted, so 25 8 * 1 - and
+// 8 25 * 1 - (or 1 2 + 3 + and 1 2 3 + +) are written alike. Used to tell distinct solutions apart.
+std::string canonical_form(const SolutionTrace& t)
+{
+	struct Node { int op; std::vector<std::string> parts; };	// op 0 for a number
+	auto text = [](const Node& n)
+	{
+		if (n.op == 0) { return n.parts[0]; }
+		std::string out = "(" + n.parts[0];
+		for (int k = 1; k < n.parts.size(); k++) { out += op_symbol(n.op) + n.parts[k]; }
+		return out + ")";
+	};
+	std::vector<Node> stack;
+	for (int k = 0; k < t.length; k++)
+	{
+		if (t.tokens[k] >= 0) { stack.push_back({ 0, { std::to_string(t.tokens[k]) } }); continue; }
+		Node b = stack.back();
+		stack.pop_back();
+		Node& a = stack.back();
+		Node n = { t.tokens[k], {} };
+		for (Node* x : { &a, &b })
+		{
+			bool flatten = (n.op == ADD || n.op == MUL) && x->op == n.op;
+			if (flatten) { n.parts.insert(n.parts.end(), x->parts.begin(), x->parts.end()); }
+			else { n.parts.push_back(text(*x)); }
+		}
+		if (n.op == ADD || n.op == MUL) { std::sort(n.parts.begin(), n.parts.end()); }
+		a = n;
+	}
+	return stack.empty() ? "" : text(stack.back());
+}
+
+// ------------------------------------------------------------------------------------------------
+// The sets of five operations to search, worked out by the compiler and stored in the program as 
+// small integer arrays so nothing needs to be built when the game starts.
+//
+// There are 56 distinct sets of five operations (allowing repeats). For each set we store the
+// distinct ways of ordering it in a game: four of the operations are permuted by the RPN 
+// permutations anyway, so only the choice of the fifth (always the last operation) matters.
+// The sets are then rearranged so that the sets most likely to make a solution are used first:
+//	-	We only add sets of operations to the list if * is one of the operations
+//	-	We only add sets of operations if they have a good variety of operations (at most 3 *, 3 +,
+//		2 - and 2 /), most orderings ==> lots of variety ==> searched first
+// For example the set (////-) is pretty much useless in finding a solution to the numbers game, 
+// whereas (*++-/) is probably much more likely to yield answers near the target number.
+// Certainly +, *  are used nearly everytime, whereas - and / see less frequent use. When a search
+// ranking is loaded this order is adapted to the numbers being played (see rank_opers).
+constexpr int MAX_OPERS = 56;
+struct OperTable
+{
+	int size;
+	std::int8_t Sets[MAX_OPERS][5];			// the five operations as opcodes
+	int Count[MAX_OPERS];					// distinct orderings of the set
+	std::int8_t Orders[MAX_OPERS][5][5];	// the orderings, last operation last
+};
+
+constexpr OperTable make_oper_table()
+{
+	constexpr std::int8_t ops[4] = { ADD, MUL, DIV, SUB };
+	OperTable all{}, T{};
+	// Every string of five operations in turn, keeping the first of each distinct set
+	for (int i = 0; i < 1024; i++)
+	{
+		std::int8_t set[5] = {};
+		int counts[5] = {}, n = 0;
+		for (int k = 0; k < 5; k++) { set[k] = ops[(i >> (2 * (4 - k))) & 3]; counts[-set[k]]++; }
+		bool repeat = false;
+		for (int t = 0; t < all.size && !repeat; t++)
+		{
+			int counts_[5] = {};
+			for (int k = 0; k < 5; k++) { counts_[-all.Sets[t][k]]++; }
+			repeat = counts_[1] == counts[1] && counts_[2] == counts[2] && counts_[3] == counts[3] && counts_[4] == counts[4];
+		}
+		if (repeat) { continue; }
+		for (int k = 0; k < 5; k++) { all.Sets[all.size][k] = set[k]; }
+		// Orderings: leave out each position in turn (from the back) to be the last operation
+		for (int last = 4; last >= 0; last--)
+		{
+			bool seen = false;
+			for (int o = 0; o < n; o++) { seen = seen || all.Orders[all.size][o][4] == set[last]; }
+			if (seen) { continue; }
+			for (int k = 0, c = 0; k < 5; k++) { if (k != last) { all.Orders[all.size][n][c++] = set[k]; } }
+			all.Orders[all.size][n][4] = set[last];
+			n++;
+		}
+		all.Count[all.size++] = n;
+	}
+	// Rearrange, most orderings first, dropping the sets without enough variety
+	for (int n = 5; n >= 1; n--)
+	{
+		for (int t = 0; t < all.size; t++)
+		{
+			int addn = 0, muln = 0, divn = 0, subn = 0;
+			for (int k = 0; k < 5; k++)
+			{
+				if (all.Sets[t][k] == MUL) { muln++; }
+				else if (all.Sets[t][k] == ADD) { addn++; }
+				else if (all.Sets[t][k] == SUB) { subn++; }
+				else { divn++; }
+			}
+			// To add or not to add to the search space
+			if (all.Count[t] != n || !(muln >= 1 && muln <= 3 && divn <= 2 && addn <= 3 && subn <= 2)) { continue; }
+			for (int k = 0; k < 5; k++) { T.Sets[T.size][k] = all.Sets[t][k]; }
+			for (int o = 0; o < n; o++) { for (int k = 0; k < 5; k++) { T.Orders[T.size][o][k] = all.Orders[t][o][k]; } }
+			T.Count[T.size++] = n;
+		}
+	}
+	return T;
+}
+constexpr OperTable Oper_table = make_oper_table();
+static_assert(Oper_table.size == 22, "unexpected number of sets of operations");
+
+// ------------------------------------------------------------------------------------------------
+// The solution made by one of the permutations of game v: the first value the permutation makes
+// equal to value (or the value made by token end), as the tokens of the permutation up to that
+// operation less any numbers below it on the stack that it did not use
+SolutionTrace make_trace(const Game& v, const std::uint8_t* Permutations_i, int value, int end = 10)
+{					// Numbers and operations		one of the permutations		value made		last token
+	SolutionTrace t{};
+	int tokens[11] = { v[0],v[1] }, stack[11], start[11], top = 0; // start of the tokens making each value
+	for (int i = 0; i < PERM_LEN; i++) { tokens[2 + i] = v[Permutations_i[i]]; }
+	for (int k = 0; k < 11; k++)
+	{
+		if (tokens[k] >= 0) { stack[top] = tokens[k]; start[top++] = k; continue; }
+		top--;
+		stack[top - 1] = (int)apply_op(tokens[k], stack[top - 1], stack[top]);
+		if (stack[top - 1] == value || k == end)
+		{
+			t.length = k + 1 - start[top - 1];
+			std::copy(tokens + start[top - 1], tokens + k + 1, t.tokens);
+			break;
+		}
+	}
+	return t;
+}
+// ------------------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------------------
+// A function that runs through combinations
+// The operand stack is a fixed array on the stack rather than a std::vector. At most six numbers 
+// can ever be waiting on the stack, so no memory is allocated while evaluating a permutation. 
+// The stack is kept for every position of the permutation so a prefix shared with the previous 
+// permutation is not evaluated again.
+const int MAX_STACK = 6;
+// ------------------------------------------------------------------------------------------------
+// The valid RPN permutations of the inner eight positions, worked out by the compiler. Positions
+// in a game are 0,1 for the two fixed numbers, 2-5 for the other numbers and 6-10 for operations,
+// where position 10 is always last. A permutation is valid as long as there are always at least
+// two numbers on the stack for an operation to act on, which leaves 24192 permutations.
+// 
+// The permutations are generated in sorted order so that permutations sharing the same first few
+// positions sit next to each other (like walking a tree of prefixes). For each row we store how 
+// many positions it shares with the row before it, so evaluation of that shared prefix can be 
+// reused. When a permutation is abandoned at position m every permutation starting the same way is
+// skipped as well. How many rows that is depends only on m and the size of the stack, so rather 
+// than a table of where to skip to for every row and depth (435KB) the few subtree sizes are kept.
+// The table is then 240KB of bytes in two flat arrays, small enough to stay in the L2 cache of 
+// every core a worker runs on.
+constexpr int PERM_ROWS = 24192;
+struct PermTable
+{
+	int size;
+	alignas(64) std::uint8_t Rows[PERM_ROWS][PERM_LEN];
+	alignas(64) std::uint8_t Shared[PERM_ROWS];		// positions row i shares with row i-1
+	// SubtreeRows[m][s] rows starting with the same m+1 positions, where the stack holds s numbers
+	// after position m
+	int SubtreeRows[PERM_LEN][MAX_STACK + 1];
+};
+
+constexpr bool is_number(int pos) { return pos < 6; }
+
+// Ways of placing n numbers and o operations onto a stack of s numbers, keeping two numbers on the
+// stack for every operation
+constexpr int rpn_orders(int n, int o, int s)
+{
+	if (n == 0 && o == 0) { return 1; }
+	return (n > 0 ? rpn_orders(n - 1, o, s + 1) : 0) + (o > 0 && s >= 2 ? rpn_orders(n, o - 1, s - 1) : 0);
+}
+constexpr int factorial(int n) { return n <= 1 ? 1 : n * factorial(n - 1); }
+
+constexpr PermTable make_perm_table()
+{
+	PermTable P{};
+	// Depth first walk over the positions 2-9 in increasing order so the rows come out sorted,
+	// cur[d] is the position currently placed at depth d (0 for none yet)
+	int cur[PERM_LEN] = {}, stack = 2, depth = 0;
+	bool used[11] = {};
+	while (depth >= 0)
+	{
+		if (depth == PERM_LEN - 1)
+		{
+			for (int k = 0; k < PERM_LEN - 1; k++) { P.Rows[P.size][k] = cur[k]; }
+			P.Rows[P.size++][PERM_LEN - 1] = 10;
+			depth--;
+			continue;
+		}
+		// Undo the position placed here before trying the next one
+		if (cur[depth] != 0) { used[cur[depth]] = false; stack -= is_number(cur[depth]) ? 1 : -1; }
+		int pos = (cur[depth] == 0) ? 2 : cur[depth] + 1;
+		while (pos <= 9 && (used[pos] || (!is_number(pos) && stack < 2))) { pos++; }
+		if (pos > 9) { cur[depth--] = 0; continue; }
+		cur[depth] = pos; used[pos] = true; stack += is_number(pos) ? 1 : -1;
+		depth++;
+	}
+	for (int i = 1; i < P.size; i++)
+	{
+		int k = 0;
+		while (k < PERM_LEN && P.Rows[i][k] == P.Rows[i - 1][k]) { k++; }
+		P.Shared[i] = k;
+	}
+	// After position m, with m+1 of the eight positions placed and s numbers on the stack, (m+s-1)/2
+	// of the four numbers have been placed. The rest of the numbers and operations can then come in
+	// any order the stack allows.
+	for (int m = 0; m < PERM_LEN - 1; m++)
+	{
+		for (int s = 1; s <= MAX_STACK; s++)
+		{
+			int numbers = (m + s - 1) / 2, n = 4 - numbers, o = 4 - (m + 1 - numbers);
+			if ((m + s - 1) % 2 != 0 || n < 0 || o < 0) { continue; }
+			P.SubtreeRows[m][s] = factorial(n) * factorial(o) * rpn_orders(n, o, s);
+		}
+	}
+	P.SubtreeRows[PERM_LEN - 1][1] = 1; // only the last operation was left
+	return P;
+}
+constexpr PermTable Perm_table = make_perm_table();
+static_assert(Perm_table.size == PERM_ROWS, "unexpected number of RPN permutations");
+static_assert(factorial(4) * factorial(4) * rpn_orders(4, 4, 2) == PERM_ROWS, "subtree sizes do not add up");
+
+// The first row after i that differs from it in positions 0..m, where the stack holds s numbers 
+// after position m. Row i starts that subtree unless it shares more than m positions with the row
+// before, which only happens for the first row of a slice, and then the subtree is walked instead.
+inline int next_subtree(const PermTable& P, int i, int m, int s)
+{
+	if (P.Shared[i] <= m) { return i + P.SubtreeRows[m][s]; }
+	do { i++; } while (i < P.size && P.Shared[i] > m);
+	return i;
+}
+
+// ------------------------------------------------------------------------------------------------
+// State shared by every worker searching the same game. The first worker to find a solution records
+// which game and row of the permutation table made it with a single compare and exchange, then
+// raises the stop flag. The solution itself is only worked out from them once the search is over.
+// Workers look at the stop flag before every permutation and at the clock every DEADLINE_CHECK
+// permutations, so the search winds down within microseconds of a solution or of the deadline.
+const int DEADLINE_CHECK = 256;
+struct SearchState
+{
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+	std::atomic<bool> stop{ false };		// solved or out of time
+	std::atomic<long long> tried{ 0 };		// permutations covered (evaluated or skipped)
+	std::atomic<unsigned long long> hit{ NO_RESULT };	// the solution as | game (32 bits) | row (32) |
+	// Nearest mode: every value made is compared with the target and the closest so far is kept in
+	// best, packed as | distance (16 bits) | above target (1) | game (15) | row (32) | so a plain
+	// atomic minimum picks the closest. The search stops once a result within goal is found.
+	bool nearest = false;
+	int goal = 0;
+	// All solutions mode: when set, every permutation making the target is handed to found (with the
+	// game, row and position it was made at) and the search goes on rather than stopping
+	std::function<void(int game, int row, int pos)> found;
+	std::atomic<unsigned long long> best{ NO_RESULT };
+	static const unsigned long long NO_RESULT = ~0ull;
+
+	// Returns the closest distance found by anyone so far
+	int improve(int dist, bool above, int game, int row)
+	{
+		unsigned long long cand = ((unsigned long long)dist << 48) | ((unsigned long long)above << 47) | ((unsigned long long)game << 32) | (unsigned)row;
+		unsigned long long cur = best.load(std::memory_order_relaxed);
+		while (cand < cur && !best.compare_exchange_weak(cur, cand)) {}
+		if (cand < cur) { cur = cand; }
+		if ((int)(cur >> 48) <= goal) { stop.store(true, std::memory_order_relaxed); }
+		return cur >> 48;
+	}
+	int best_distance() const { return best.load(std::memory_order_relaxed) >> 48; }
+	bool best_above() const { return (best.load() >> 47) & 1; }
+	int best_game() const { return (best.load() >> 32) & 0x7fff; }
+	int best_row() const { return best.load() & 0xffffffff; }
+
+	// Returns false if another worker got there first
+	bool publish(int game, int row)
+	{
+		unsigned long long none = NO_RESULT;
+		if (!hit.compare_exchange_strong(none, ((unsigned long long)game << 32) | (unsigned)row)) { return false; }
+		stop.store(true, std::memory_order_relaxed);
+		return true;
+	}
+	bool solved() const { return hit.load() != NO_RESULT; }
+	int hit_game() const { return hit.load() >> 32; }
+	int hit_row() const { return hit.load() & 0xffffffff; }
+	bool timed_out()
+	{
+		if (std::chrono::steady_clock::now() < deadline) { return false; }
+		stop.store(true, std::memory_order_relaxed);
+		return true;
+	}
+};
+
+// ------------------------------------------------------------------------------------------------
+// Metrics
+// Every worker thread of a pool has its own counters, on their own cache line so the workers never 
+// contend for them. eval_ keeps its counts in local variables and adds them to the counters of the
+// worker it runs on once it is finished, so the inner loop pays nothing for them. Only the owning
+// worker writes its counters (so a relaxed load and store is enough) while anyone can read them.
+struct alignas(64) WorkerSlot
+{
+	std::atomic<long long> evaluations{ 0 }, positions{ 0 }, depth{ 0 }, repeats{ 0 }, solutions{ 0 }, tasks{ 0 }, busy_ns{ 0 };
+	std::atomic<long long> prunes[NUM_PRUNES] = {};
+};
+// The counters of the worker running on this thread, none for threads outside a pool
+thread_local WorkerSlot* current_slot = nullptr;
+
+void bump(std::atomic<long long>& c, long long n)
+{
+	c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+// Adds the counts of one call of eval_ to the current worker
+void count_work(long long evaluations, long long positions, long long depth, const long long* prunes, long long repeats, long long solutions)
+{
+	WorkerSlot* w = current_slot;
+	if (!w) { return; }
+	bump(w->evaluations, evaluations); bump(w->positions, positions); bump(w->depth, depth); bump(w->solutions, solutions);
+	for (int r = 0; r < NUM_PRUNES; r++) { bump(w->prunes[r], prunes[r]); }
+	bump(w->repeats, repeats);
+}
+// Adds permutations left out as repeats of others to the current worker
+void count_repeats(long long repeats)
+{
+	if (current_slot) { bump(current_slot->repeats, repeats); }
+}
+
+const char* prune_name(int rule)
+{
+	const char* names[] = { "mul_one", "sub_not_positive", "sub_equal", "div_fraction", "div_equal", "div_one", "repeat", "commute", "associate" };
+	return names[rule];
+}
+
+// ------------------------------------------------------------------------------------------------
+// Twins: when two of the permuted positions of a game hold the same number (or the same operation)
+// every permutation has a twin with the two swapped, which makes exactly the same values. Only the
+// permutations placing the first of the two first are evaluated: twin[q] is the position that has 
+// to be placed before position q, as a bit, and a prefix placing q before it is abandoned along with
+// every permutation starting the same way.
+void find_twins(const Game& v, std::uint16_t* twin)
+{
+	for (int q = 0; q < 11; q++) { twin[q] = 0; }
+	for (int q = 3; q < 10; q++)
+	{
+		for (int p = q - 1; p >= (is_number(q) ? 2 : 6); p--)
+		{
+			if (v[p] == v[q]) { twin[q] = 1 << p; break; }
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------------------
+// Canonical form: a b + and b a + make the same value, as do a x y + + and a x + y + (likewise for
+// *), and the table holds both of each pair. Only sums and products with the larger operand first
+// and chains bracketed from the left are evaluated, any other prefix is abandoned along with every
+// permutation starting the same way: swapping or regrouping the operands only reorders the prefix,
+// so another permutation makes the same stack and goes on exactly as the abandoned ones would have.
+// The first two numbers always start the permutation, so an operand holding either of them is left
+// where it is: fixed[m] counts the entries at the bottom of the stack that hold them (2 until the
+// two are combined, then 1).
+
+// ------------------------------------------------------------------------------------------------
+// Only rows first <= i < last of the table are evaluated so the search can be split into slices.
+// id identifies the game when recording a solution, or the closest result in nearest mode. Returns
+// true if this call found the solution.
+bool eval_(const Game& v, const PermTable& P, int &T, int first, int last, SearchState& S, int id = 0)
+{					// Numbers and operations			table of 24192 permutations		Target		slice		shared state
+	// -------------------------------------
+	int v6[PERM_LEN + 1][MAX_STACK] = { { v[0],v[1] } }, top[PERM_LEN + 1] = { 1 }; // top of the stack
+	std::uint16_t twin[11], placed[PERM_LEN + 1] = {}; // positions placed before each depth
+	find_twins(v, twin);
+	int fixed[PERM_LEN + 1] = { 2 }; // stack entries holding the first two numbers (see canonical form)
+	int i = first, visited = 0, best = S.best_distance();
+	long long depth = 0, shared = 0, prunes[NUM_PRUNES] = {}, repeats = 0, hits = 0; // evaluations are counted by visited
+	while (i < last)
+	{
+		// Bail out if someone else has found a solution or we are out of time
+		if (S.stop.load(std::memory_order_relaxed)) { break; }
+		if ((visited + 1) % DEADLINE_CHECK == 0 && S.timed_out()) { break; }
+		visited++;
+		// while loop to evaluate the vector of numbers and operations		
+		// Variable initialisation
+		const std::uint8_t* perm = P.Rows[i];
+		int m = (i == first) ? 0 : P.Shared[i], tot_curr = 0;
+		bool repeat = false;
+		shared += m;
+		for (; m < PERM_LEN; m++)
+		{
+			const int* cur = v6[m]; int* nxt = v6[m + 1]; int ind_ = top[m];
+			int pos = perm[m], tok = v[pos];
+			if (twin[pos] & ~placed[m]) { prunes[PRUNE_REPEAT]++; repeat = true; break; } // placed before its twin
+			placed[m + 1] = placed[m] | (1 << pos);
+			if (tok >= 0) // number, push onto the stack
+			{
+				for (int k = 0; k <= ind_; k++) { nxt[k] = cur[k]; }
+				nxt[ind_ + 1] = tok; top[m + 1] = ind_ + 1; fixed[m + 1] = fixed[m];
+				continue; 
+			} 
+			int a = cur[ind_ - 1], b = cur[ind_];
+			fixed[m + 1] = (ind_ == 1) ? 1 : fixed[m];
+			if (tok == ADD)
+			{
+				tot_curr = a + b; 
+			}
+			else if (tok == MUL)
+			{
+				if (b == 1 || a == 1) { prunes[PRUNE_MUL_ONE]++; break; } // No benefit to multiplying by 1
+				else { tot_curr = a * b; }
+			}
+			else if (tok == SUB)
+			{
+				// Check
+				if (a - b <= 0) { prunes[PRUNE_SUB_NOT_POSITIVE]++; break; }
+				else if (a - b == b) { prunes[PRUNE_SUB_EQUAL]++; break; } // a-b=b (e.g. 10-5=5) worthless calculation
+				else { tot_curr = a - b; }
+			}
+			else
+			{
+				// Check cout << "here" << endl;
+				if ((a / b) * b != a) { prunes[PRUNE_DIV_FRACTION]++; break; }
+				else if (a / b == b) { prunes[PRUNE_DIV_EQUAL]++; break; } // Worthless computation when a/b=b (25/5=5)
+				else if (b == 1) { prunes[PRUNE_DIV_ONE]++; break; } // No benefit in dividing by 1
+				else { tot_curr = a / b; }
+			}
+			if (tok == ADD || tok == MUL)
+			{
+				if (a < b && ind_ > fixed[m]) { prunes[PRUNE_COMMUTE]++; break; } // b a is made instead
+				if (v[m > 0 ? perm[m - 1] : 1] == tok) { prunes[PRUNE_ASSOCIATE]++; break; } // a (x y +) + is made as a x + y +
+			}
+			for (int k = 0; k < ind_ - 1; k++) { nxt[k] = cur[k]; }
+			nxt[ind_ - 1] = tot_curr; top[m + 1] = ind_ - 1;
+			if (tot_curr == T)
+			{
+				if (S.found) { hits++; S.found(id, i, m); continue; } // all solutions: hand it over and go on
+				depth += m + 1;
+				count_work(visited, depth - shared, depth, prunes, repeats, true);
+				S.tried += i - first + 1;
+				return S.publish(id, i);
+			}
+			if (S.nearest && std::abs(tot_curr - T) < best && std::abs(tot_curr - T) <= 0xffff)
+			{
+				best = S.improve(std::abs(tot_curr - T), tot_curr > T, id, i);
+			}
+		}
+		depth += m;
+		// Abandoned at position m ==> skip every permutation starting with the same m+1 positions
+		if (m < PERM_LEN)
+		{
+			int next = next_subtree(P, i, m, is_number(perm[m]) ? top[m] + 2 : top[m]);
+			if (repeat) { repeats += std::min(next, last) - i; }
+			i = next;
+		}
+		else { i++; }
+	}
+	count_work(visited, depth - shared, depth, prunes, repeats, hits);
+	S.tried += std::min(i, last) - first;
+	// -------------------------------------std::cout << "here\n";
+	return false;
+}
+bool eval_(const Game& v, const PermTable& P, int &T)
+{
+	SearchState S;
+	return eval_(v, P, T, 0, P.size, S);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Vectorised evaluation
+// Every game of a search walks the same table of permutations, so LANES games can be evaluated at
+// once: each position of a permutation is a number or an operation in all of the games alike, only
+// which number or which operation differs. The stack then holds a vector of LANES values per entry
+// and each operation is worked out for every lane, with the operation of each lane picked out by
+// a mask. The rules eval_ uses to abandon a permutation become masks that take lanes out of play,
+// and the permutations sharing a prefix are only skipped once every lane has been taken out. 
+//
+// The lanes are 32 bit integers in AVX2 or SSE4.1 registers, whichever the compiler is allowed to 
+// use (e.g. -mavx2 or /arch:AVX2). There is no vector integer division, so division is done in 
+// double precision, which is exact for 32 bit integers. Without either, eval_ is used one game at
+// a time (emulating the lanes with plain arrays is slower than that).
+#if defined(__AVX2__)
+#define VECTORISED
+const int LANES = 8;
+#include<immintrin.h>
+struct Lanes
+{
+	typedef __m256i V;
+	static V set1(int x) { return _mm256_set1_epi32(x); }
+	static V load(const int* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+	static V mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+	static V div(V a, V b)
+	{
+		__m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(a)), _mm256_cvtepi32_pd(_mm256_castsi256_si128(b))));
+		__m128i hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1)), _mm256_cvtepi32_pd(_mm256_extracti128_si256(b, 1))));
+		return _mm256_set_m128i(hi, lo);
+	}
+	static V eq(V a, V b) { return _mm256_cmpeq_epi32(a, b); }
+	static V gt(V a, V b) { return _mm256_cmpgt_epi32(a, b); }
+	static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+	static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+	static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); } // ~a & b
+	static V select(V m, V a, V b) { return _mm256_blendv_epi8(b, a, m); } // m ? a : b
+	static int bits(V m) { return _mm256_movemask_ps(_mm256_castsi256_ps(m)); }
+};
+#elif defined(__SSE4_1__)
+#define VECTORISED
+const int LANES = 8;
+#include<smmintrin.h>
+struct Lanes
+{
+	struct V { __m128i lo, hi; };
+	static V set1(int x) { return { _mm_set1_epi32(x), _mm_set1_epi32(x) }; }
+	static V load(const int* p) { return { _mm_loadu_si128((const __m128i*)p), _mm_loadu_si128((const __m128i*)(p + 4)) }; }
+	static V add(V a, V b) { return { _mm_add_epi32(a.lo, b.lo), _mm_add_epi32(a.hi, b.hi) }; }
+	static V sub(V a, V b) { return { _mm_sub_epi32(a.lo, b.lo), _mm_sub_epi32(a.hi, b.hi) }; }
+	static V mul(V a, V b) { return { _mm_mullo_epi32(a.lo, b.lo), _mm_mullo_epi32(a.hi, b.hi) }; }
+	static __m128i div4(__m128i a, __m128i b)
+	{
+		__m128i lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(a), _mm_cvtepi32_pd(b)));
+		__m128i hi = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(a, a)), _mm_cvtepi32_pd(_mm_unpackhi_epi64(b, b))));
+		return _mm_unpacklo_epi64(lo, hi);
+	}
+	static V div(V a, V b) { return { div4(a.lo, b.lo), div4(a.hi, b.hi) }; }
+	static V eq(V a, V b) { return { _mm_cmpeq_epi32(a.lo, b.lo), _mm_cmpeq_epi32(a.hi, b.hi) }; }
+	static V gt(V a, V b) { return { _mm_cmpgt_epi32(a.lo, b.lo), _mm_cmpgt_epi32(a.hi, b.hi) }; }
+	static V or_(V a, V b) { return { _mm_or_si128(a.lo, b.lo), _mm_or_si128(a.hi, b.hi) }; }
+	static V and_(V a, V b) { return { _mm_and_si128(a.lo, b.lo), _mm_and_si128(a.hi, b.hi) }; }
+	static V andnot(V a, V b) { return { _mm_andnot_si128(a.lo, b.lo), _mm_andnot_si128(a.hi, b.hi) }; }
+	static V select(V m, V a, V b) { return { _mm_blendv_epi8(b.lo, a.lo, m.lo), _mm_blendv_epi8(b.hi, a.hi, m.hi) }; }
+	static int bits(V m) { return _mm_movemask_ps(_mm_castsi128_ps(m.lo)) | (_mm_movemask_ps(_mm_castsi128_ps(m.hi)) << 4); }
+};
+#endif
+
+int popcount(int x)
+{
+	int n = 0;
+	for (; x; x &= x - 1) { n++; }
+	return n;
+}
+
+#ifdef VECTORISED
+
+// Evaluates rows first <= i < last for the count (up to LANES) games at once, as eval_ does for one,
+// where the games are numbered from id
+bool eval_lanes(const Game* games, int count, const PermTable& P, int T, int first, int last, SearchState& S, int id)
+{
+	typedef Lanes::V V;
+	// Position p of every game side by side, the lanes past count copy the first game but are never
+	// in play. For the operations, which lanes have each operation and which operations turn up.
+	int tok[11][LANES];
+	for (int p = 0; p < 11; p++) { for (int l = 0; l < LANES; l++) { tok[p][l] = games[l < count ? l : 0][p]; } }
+	V num[11], is_op[11][4];
+	int ops_used[11] = {};
+	for (int p = 0; p < 11; p++)
+	{
+		num[p] = Lanes::load(tok[p]);
+		for (int o = 0; o < 4; o++)
+		{
+			is_op[p][o] = Lanes::eq(num[p], Lanes::set1(-(o + 1)));
+			if (Lanes::bits(is_op[p][o]) & ((1 << count) - 1)) { ops_used[p] |= 1 << o; }
+		}
+	}
+	// twin_lanes[q][p] the lanes where position p has to be placed before position q (see find_twins)
+	int twin_lanes[11][11] = {};
+	bool has_twin[11] = {};
+	for (int l = 0; l < count; l++)
+	{
+		std::uint16_t twin[11];
+		find_twins(games[l], twin);
+		for (int q = 0; q < 11; q++)
+		{
+			for (int p = 0; p < q; p++) { if (twin[q] == 1 << p) { twin_lanes[q][p] |= 1 << l; has_twin[q] = true; } }
+		}
+	}
+	const V zero = Lanes::set1(0), one = Lanes::set1(1), target = Lanes::set1(T);
+	V st[PERM_LEN + 1][MAX_STACK];
+	int top[PERM_LEN + 1] = { 1 }, alive[PERM_LEN + 1] = { (1 << count) - 1 }, placed[PERM_LEN + 1] = {}, fixed[PERM_LEN + 1] = { 2 };
+	st[0][0] = num[0]; st[0][1] = num[1];
+	int i = first, visited = 0;
+	long long depth = 0, shared = 0, prunes[NUM_PRUNES] = {}, repeats = 0;
+	while (i < last)
+	{
+		if (S.stop.load(std::memory_order_relaxed)) { break; }
+		if ((visited + 1) % DEADLINE_CHECK == 0 && S.timed_out()) { break; }
+		visited++;
+		const std::uint8_t* perm = P.Rows[i];
+		int m = (i == first) ? 0 : P.Shared[i];
+		shared += m;
+		for (; m < PERM_LEN; m++)
+		{
+			const V* cur = st[m]; V* nxt = st[m + 1]; int ind_ = top[m], pos = perm[m], out = 0;
+			// Lanes placing pos before its twin are out, for every permutation starting the same way
+			if (has_twin[pos])
+			{
+				for (int p = 2; p < pos; p++) { if (!((placed[m] >> p) & 1)) { out |= twin_lanes[pos][p]; } }
+				out &= alive[m];
+				if (out)
+				{
+					prunes[PRUNE_REPEAT] += popcount(out);
+					repeats += (long long)popcount(out) * (std::min(next_subtree(P, i, m, is_number(pos) ? ind_ + 2 : ind_), last) - i);
+				}
+			}
+			placed[m + 1] = placed[m] | (1 << pos);
+			if (is_number(pos))
+			{
+				for (int k = 0; k <= ind_; k++) { nxt[k] = cur[k]; }
+				nxt[ind_ + 1] = num[pos]; top[m + 1] = ind_ + 1; alive[m + 1] = alive[m] & ~out; fixed[m + 1] = fixed[m];
+				if (alive[m + 1] == 0) { break; }
+				continue;
+			}
+			V a = cur[ind_ - 1], b = cur[ind_], res = zero, rule[NUM_PRUNES];
+			int used = ops_used[pos];
+			fixed[m + 1] = (ind_ == 1) ? 1 : fixed[m];
+			for (int r = 0; r < NUM_PRUNES; r++) { rule[r] = zero; }
+			if (used & 3)
+			{
+				V sum_or_product = Lanes::or_(is_op[pos][0], is_op[pos][1]);
+				if (ind_ > fixed[m]) { rule[PRUNE_COMMUTE] = Lanes::and_(sum_or_product, Lanes::gt(b, a)); }
+				int prev = (m > 0) ? perm[m - 1] : 1;
+				if (!is_number(prev))
+				{
+					rule[PRUNE_ASSOCIATE] = Lanes::or_(Lanes::and_(is_op[pos][0], is_op[prev][0]), Lanes::and_(is_op[pos][1], is_op[prev][1]));
+				}
+			}
+			if (used & 1) { res = Lanes::select(is_op[pos][0], Lanes::add(a, b), res); }
+			if (used & 2)
+			{
+				rule[PRUNE_MUL_ONE] = Lanes::and_(is_op[pos][1], Lanes::or_(Lanes::eq(a, one), Lanes::eq(b, one)));
+				res = Lanes::select(is_op[pos][1], Lanes::mul(a, b), res);
+			}
+			if (used & 4)
+			{
+				V d = Lanes::sub(a, b), not_positive = Lanes::andnot(Lanes::gt(d, zero), is_op[pos][2]);
+				rule[PRUNE_SUB_NOT_POSITIVE] = not_positive;
+				rule[PRUNE_SUB_EQUAL] = Lanes::andnot(not_positive, Lanes::and_(is_op[pos][2], Lanes::eq(d, b)));
+				res = Lanes::select(is_op[pos][2], d, res);
+			}
+			if (used & 8)
+			{
+				V q = Lanes::div(a, b), fraction = Lanes::andnot(Lanes::eq(Lanes::mul(q, b), a), is_op[pos][3]);
+				V equal = Lanes::andnot(fraction, Lanes::and_(is_op[pos][3], Lanes::eq(q, b)));
+				rule[PRUNE_DIV_FRACTION] = fraction;
+				rule[PRUNE_DIV_EQUAL] = equal;
+				rule[PRUNE_DIV_ONE] = Lanes::andnot(Lanes::or_(fraction, equal), Lanes::and_(is_op[pos][3], Lanes::eq(b, one)));
+				res = Lanes::select(is_op[pos][3], q, res);
+			}
+			for (int r = 0; r < NUM_PRUNES; r++)
+			{
+				int hit = Lanes::bits(rule[r]) & alive[m] & ~out;
+				if (hit) { prunes[r] += popcount(hit); out |= hit; }
+			}
+			for (int k = 0; k < ind_ - 1; k++) { nxt[k] = cur[k]; }
+			nxt[ind_ - 1] = res; top[m + 1] = ind_ - 1; alive[m + 1] = alive[m] & ~out;
+			int solved = Lanes::bits(Lanes::eq(res, target)) & alive[m + 1];
+			if (solved)
+			{
+				int lane = 0;
+				while (!((solved >> lane) & 1)) { lane++; }
+				depth += m + 1;
+				count_work((long long)visited * count, (depth - shared) * count, depth * count, prunes, repeats, true);
+				S.tried += (long long)(i - first + 1) * count;
+				return S.publish(id + lane, i);
+			}
+			if (alive[m + 1] == 0) { break; }
+		}
+		depth += m;
+		// Every lane abandoned at position m ==> skip every permutation starting with the same m+1 positions
+		if (m < PERM_LEN) { i = next_subtree(P, i, m, is_number(perm[m]) ? top[m] + 2 : top[m]); }
+		else { i++; }
+	}
+	count_work((long long)visited * count, (depth - shared) * count, depth * count, prunes, repeats, false);
+	S.tried += (long long)(std::min(i, last) - first) * count;
+	return false;
+}
+#else
+const int LANES = 1;
+#endif
+
+// ------------------------------------------------------------------------------------------------
+// A pool of worker threads that lives for the whole game, sized to the number of cores available.
+// Each worker has its own queue of tasks: it takes tasks from the front of its own queue and when 
+// that runs dry it steals from the back of another worker's queue, so every core stays busy until 
+// the last task is done.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(int n = std::thread::hardware_concurrency())
+	{
+		if (n < 1) { n = 1; }
+		slots.reset(new WorkerSlot[n]);
+		for (int i = 0; i < n; i++) { queues.emplace_back(new Queue); }
+		for (int i = 0; i < n; i++) { workers.emplace_back([this, i]() { run(i); }); }
+	}
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m);
+			stop = true;
+		}
+		cv.notify_all();
+		for (std::thread& w : workers) { w.join(); }
+	}
+	int size() const { return workers.size(); }
+	const WorkerSlot& counters(int i) const { return slots[i]; }
+
+	// Tasks are handed out to the workers' queues in turn
+	void submit(std::function<void()> task)
+	{
+		Queue& q = *queues[next++ % queues.size()];
+		{
+			std::lock_guard<std::mutex> lock(q.m);
+			q.tasks.push_back(std::move(task));
+		}
+		{
+			std::lock_guard<std::mutex> lock(m);
+			queued++; pending++;
+		}
+		cv.notify_one();
+	}
+	// Blocks until every submitted task has finished
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		done_cv.wait(lock, [this]() { return pending == 0; });
+	}
+	// Tasks submitted as part of a group can be waited for on their own, so several games can be
+	// solved on the same pool at once
+	struct Group
+	{
+		std::mutex m;
+		std::condition_variable cv;
+		int pending = 0;
+	};
+	void submit(Group& g, std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(g.m);
+			g.pending++;
+		}
+		submit([&g, task]()
+		{
+			task();
+			std::lock_guard<std::mutex> lock(g.m);
+			if (--g.pending == 0) { g.cv.notify_all(); }
+		});
+	}
+	void wait(Group& g)
+	{
+		std::unique_lock<std::mutex> lock(g.m);
+		g.cv.wait(lock, [&g]() { return g.pending == 0; });
+	}
+private:
+	struct Queue
+	{
+		std::mutex m;
+		std::deque<std::function<void()>> tasks;
+	};
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::unique_ptr<WorkerSlot[]> slots;
+	std::vector<std::thread> workers;
+	std::mutex m;
+	std::condition_variable cv, done_cv;
+	int queued = 0, pending = 0;	// tasks waiting in queues, tasks not yet finished
+	std::atomic<unsigned> next{ 0 };
+	bool stop = false;
+
+	bool take(int id, std::function<void()>& task)
+	{
+		for (int k = 0; k < queues.size(); k++)
+		{
+			Queue& q = *queues[(id + k) % queues.size()];
+			std::lock_guard<std::mutex> lock(q.m);
+			if (q.tasks.empty()) { continue; }
+			if (k == 0) { task = std::move(q.tasks.front()); q.tasks.pop_front(); }	// own queue
+			else { task = std::move(q.tasks.back()); q.tasks.pop_back(); }			// steal
+			return true;
+		}
+		return false;
+	}
+	void run(int id)
+	{
+		current_slot = &slots[id];
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m);
+				cv.wait(lock, [this]() { return stop || queued > 0; });
+				if (queued == 0) { return; } // stopping and nothing left to do
+				queued--;
+			}
+			// A task is guaranteed to be waiting in one of the queues for us
+			std::function<void()> task;
+			while (!take(id, task)) {}
+			auto start = std::chrono::steady_clock::now();
+			task();
+			bump(slots[id].busy_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			bump(slots[id].tasks, 1);
+			std::lock_guard<std::mutex> lock(m);
+			if (--pending == 0) { done_cv.notify_all(); }
+		}
+	}
+};
+
+// ------------------------------------------------------------------------------------------------
+// Subset dynamic programming solver
+// An alternative to the RPN search. For each of the 63 non-empty subsets of the six numbers we build
+// the set of every value that can be made using exactly those numbers, by combining the values of 
+// two disjoint subsets under the same rules as eval_ (no negatives or fractions, and the same 
+// pointless operations skipped). Each value remembers how it was made so the expression can be 
+// rebuilt. As every reachable value is known this can prove that a game has no solution.
+// Unlike the RPN search nothing is tied to six numbers: the work grows with the number of values
+// each subset makes (about 3^n pairs of subsets are combined) rather than with the n! orders of the
+// numbers, so it is also the engine for games with more or fewer numbers. Values are 64 bit, and 
+// sums and products that would overflow even that are left out.
+enum DPStatus { DP_SOLVED, DP_NEAREST, DP_NONE, DP_TIMED_OUT };
+struct DPStep
+{
+	int left_mask;
+	long long left, right;
+	int op;					// 0 for one of the numbers themselves
+};
+struct DPResult
+{
+	DPStatus status;
+	long long value;		// closest value made (== Target when solved)
+	SolutionTrace solution;
+	long long values;		// number of (subset, value) pairs built
+};
+
+typedef std::vector<std::unordered_map<long long, DPStep>> DPTable;
+const long long DP_MAX = std::numeric_limits<long long>::max();
+
+// Works out every value of mask from the values of the smaller subsets, returns false if the 
+// deadline passes first
+bool dp_combine(DPTable& R, const std::vector<std::vector<long long>>& values, int mask, std::chrono::steady_clock::time_point deadline)
+{
+	std::unordered_map<long long, DPStep>& M = R[mask];
+	// Split mask into two disjoint non-empty parts, each unordered pair once
+	size_t pairs = 0;
+	for (int sub = (mask - 1) & mask; sub > 0; sub = (sub - 1) & mask)
+	{
+		if (sub >= (mask ^ sub)) { pairs += values[sub].size() * values[mask ^ sub].size(); }
+	}
+	if (std::chrono::steady_clock::now() >= deadline) { return false; }
+	M.reserve(pairs / 2); // most pairs make a value already made, rehashing as it grows costs more
+	int checked = 0; // the clock is looked at every DEADLINE_CHECK pairs, one x can have many y
+	for (int sub = (mask - 1) & mask; sub > 0; sub = (sub - 1) & mask)
+	{
+		int rest = mask ^ sub;
+		if (sub < rest) { continue; }
+		for (long long x : values[sub])
+		{
+			for (long long y : values[rest])
+			{
+				if (++checked % DEADLINE_CHECK == 0 && std::chrono::steady_clock::now() >= deadline) { return false; }
+				long long a = x, b = y;
+				int a_mask = sub;
+				if (a < b) { std::swap(a, b); a_mask = rest; } // a >= b
+				if (a <= DP_MAX - b) { M.insert({ a + b, { a_mask, a, b, ADD } }); }
+				if (b != 1 && a <= DP_MAX / b) { M.insert({ a * b, { a_mask, a, b, MUL } }); } // No benefit to multiplying by 1
+				if (a - b > 0 && a - b != b) { M.insert({ a - b, { a_mask, a, b, SUB } }); }
+				if (b != 1 && a % b == 0 && a / b != b) { M.insert({ a / b, { a_mask, a, b, DIV } }); }
+			}
+		}
+	}
+	return true;
+}
+
+// Builds every value of the subsets of up to largest numbers. The subsets of one size only need the
+// smaller ones, so given a pool each size is built in parallel. Returns false if the deadline 
+// passes first.
+bool dp_build(const std::vector<int>& numbers, DPTable& R, int largest = MAX_TILES, ThreadPool* pool = nullptr,
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max())
+{
+	int n = numbers.size(), full = (1 << n) - 1;
+	R.assign(full + 1, {});
+	std::vector<std::vector<long long>> values(full + 1); // of each subset, to walk them quickly
+	for (int i = 0; i < n; i++) { R[1 << i][numbers[i]] = { 0, numbers[i], 0, 0 }; values[1 << i] = { numbers[i] }; }
+	std::atomic<bool> late{ false };
+	auto build = [&](int mask)
+	{
+		if (late || !dp_combine(R, values, mask, deadline)) { late = true; return; }
+		for (auto& x : R[mask]) { values[mask].push_back(x.first); }
+	};
+	for (int size = 2; size <= std::min(n, largest) && !late; size++)
+	{
+		ThreadPool::Group group;
+		for (int mask = 1; mask <= full; mask++)
+		{
+			if (popcount(mask) != size) { continue; }
+			if (pool) { pool->submit(group, [&build, mask]() { build(mask); }); }
+			else { build(mask); }
+		}
+		if (pool) { pool->wait(group); }
+	}
+	return !late;
+}
+
+// The subsets of the most numbers make by far the most values, but a game only wants the few values
+// near the target. So dp_solve builds the subsets of up to built numbers and only asks the larger
+// ones whether they make a value: each way of splitting the subset in two is tried from the side
+// that was built (the one making fewer values if both were), pairing each of its values x with the
+// y the other side would need for x + y, x - y, y - x, x * y, x / y or y / x to be the value, and
+// asking the other side for y in turn. Values found are added to R with how they were made, values
+// not found are remembered in missing.
+struct DPSearch
+{
+	DPTable& R;
+	int built;
+	std::chrono::steady_clock::time_point deadline;
+	std::vector<std::unordered_set<long long>> missing;
+	bool late = false;
+};
+bool dp_makes(DPSearch& D, int mask, long long value)
+{
+	std::unordered_map<long long, DPStep>& M = D.R[mask];
+	if (M.count(value)) { return true; }
+	if (popcount(mask) <= D.built || D.missing[mask].count(value) || D.late) { return false; }
+	const int OPS[6] = { ADD, SUB, SUB, MUL, DIV, DIV };
+	for (int sub = (mask - 1) & mask; sub > 0; sub = (sub - 1) & mask)
+	{
+		int rest = mask ^ sub;
+		if (sub < rest) { continue; }
+		bool sub_built = popcount(sub) <= D.built, rest_built = popcount(rest) <= D.built;
+		int small = (sub_built && (!rest_built || D.R[sub].size() <= D.R[rest].size())) ? sub : rest, large = mask ^ small;
+		for (auto& xs : D.R[small])
+		{
+			if (std::chrono::steady_clock::now() >= D.deadline) { D.late = true; return false; }
+			long long x = xs.first, r = value;
+			long long y[6] = { r - x, x - r, (x <= DP_MAX - r) ? r + x : 0, (r % x == 0) ? r / x : 0, (x % r == 0) ? x / r : 0, (x <= DP_MAX / r) ? r * x : 0 };
+			// The rules of dp_combine: no multiplying or dividing by 1, nor a - b = b or a / b = b
+			if (x == 1) { y[3] = y[5] = 0; }
+			if (x == r) { y[2] = y[5] = 0; }
+			if (y[1] == r) { y[1] = 0; }
+			if (y[3] == 1) { y[3] = 0; }
+			if (y[4] == 1 || y[4] == r) { y[4] = 0; }
+			for (int w = 0; w < 6; w++)
+			{
+				if (y[w] < 1 || !dp_makes(D, large, y[w])) { continue; }
+				bool x_left = (w != 2 && w != 5); // y - x and y / x have y on the left
+				M[value] = { x_left ? small : large, x_left ? x : y[w], x_left ? y[w] : x, OPS[w] };
+				return true;
+			}
+		}
+	}
+	D.missing[mask].insert(value);
+	return false;
+}
+
+// Appends the RPN tokens for value made from the numbers in mask
+void dp_trace(const DPTable& R, int mask, long long value, SolutionTrace& t)
+{
+	const DPStep& st = R[mask].at(value);
+	if (st.op == 0) { t.tokens[t.length++] = (int)value; return; }
+	dp_trace(R, st.left_mask, st.left, t);
+	dp_trace(R, mask ^ st.left_mask, st.right, t);
+	t.tokens[t.length++] = st.op;
+}
+
+DPResult dp_solve(const std::vector<int>& numbers, int Target, DPTable& R, ThreadPool* pool, std::chrono::steady_clock::time_point deadline)
+{
+	DPResult res = { DP_NONE, 0, {}, 0 };
+	int n = numbers.size(), full = (1 << n) - 1;
+	DPSearch D = { R, std::max(1, n - 2), deadline, std::vector<std::unordered_set<long long>>(full + 1) };
+	if (!dp_build(numbers, R, D.built, pool, deadline)) { res.status = DP_TIMED_OUT; return res; }
+	long long best = NEAREST_RANGE + 1;
+	int best_mask = 0;
+	for (int mask = 1; mask <= full; mask++)
+	{
+		res.values += R[mask].size();
+		for (auto& x : R[mask])
+		{
+			long long d = std::abs(x.first - Target);
+			if (d < best) { best = d; best_mask = mask; res.value = x.first; }
+		}
+	}
+	// The larger subsets are asked for the values closer than that, nearest first
+	for (long long d = 0; d < best; d++)
+	{
+		for (long long r : { Target - d, Target + d })
+		{
+			for (int mask = 1; mask <= full && r >= 1 && d < best; mask++)
+			{
+				if (popcount(mask) > D.built && dp_makes(D, mask, r)) { best = d; best_mask = mask; res.value = r; }
+			}
+		}
+		if (D.late) { res.status = DP_TIMED_OUT; return res; }
+	}
+	if (best > NEAREST_RANGE) { return res; }
+	res.status = (best == 0) ? DP_SOLVED : DP_NEAREST;
+	dp_trace(R, best_mask, res.value, res.solution);
+	return res;
+}
+DPResult dp_solve(const std::vector<int>& numbers, int Target, ThreadPool* pool = nullptr,
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max())
+{
+	auto R = std::make_shared<DPTable>();
+	DPResult res = dp_solve(numbers, Target, *R, pool, deadline);
+	// Freeing millions of values takes a good part of the time it took to make them, a worker does
+	// it so the answer is not held up (past the deadline)
+	if (pool) { pool->submit([R = std::move(R)]() {}); }
+	return res;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Draws tiles numbers at random, large from the large numbers and the rest from the small numbers
+std::vector<int> random_draw(int large, std::mt19937& gen, int tiles)
+{
+	std::vector<int> NUMBERS;
+	int j = 0, small = tiles - large; std::vector<int> LargeNumbers_temp = {25,50,75,100};
+	while (j < large)
+	{
+		std::uniform_int_distribution<> distr(0, LargeNumbers_temp.size() - 1); int a = distr(gen);
+		NUMBERS.push_back(LargeNumbers_temp[a]);
+		LargeNumbers_temp.erase(LargeNumbers_temp.begin() + a);
+		j++;
+	}
+	int i = 0; std::vector<int> SmallNumbers_temp = { 1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10 };
+	while (i < small)
+	{
+		std::uniform_int_distribution<> distr(0, SmallNumbers_temp.size() - 1); int b = distr(gen);
+		NUMBERS.push_back(SmallNumbers_temp[b]);
+		SmallNumbers_temp.erase(SmallNumbers_temp.begin() + b);
+		i++;
+	}
+	return NUMBERS;
+}
+
+// Every way of having two fixed numbers at the beginning (15 of them), each followed by the other
+// four numbers. Row p starts with the pair makeCombi(6, 2)[p].
+std::vector<std::vector<int>> make_numbers_combn(const std::vector<int>& NUMBERS)
+{
+	std::vector<std::vector<int>> Numbers_combn = makeCombi(NUMBERS.size(), 2);
+	// Note: does not account for repeats, 15 vectors produced
+	// To be run at the beginning of the game, does not need to be run during finding solutions
+	for (int p = 0; p < Numbers_combn.size(); p++)
+	{
+		// Combinations already made above
+		//std::vector<int> n_tmp = NUMBERS;
+		std::vector<int> positions = { 0,1,2,3,4,5 };
+		for (int k = 0; k < Numbers_combn[p].size(); k++)
+		{
+			// Replace with number values
+			Numbers_combn[p][k] = Numbers_combn[p][k]-1;
+			for (int j = 0; j < positions.size(); j++)
+			{
+				if (positions[j] == Numbers_combn[p][k]) { positions.erase(positions.begin() + j); }
+			}
+			/*
+			Numbers_combn[p][k] = NUMBERS[Numbers_combn[p][k] - 1];
+			for (int j = 0; j < n_tmp.size(); j++)
+			{
+				if (Numbers_combn[p][k] == n_tmp[j]) { n_tmp.erase(n_tmp.begin() + j); }
+			}
+			*/
+		}	
+		Numbers_combn[p][0] = NUMBERS[Numbers_combn[p][0]];
+		Numbers_combn[p][1] = NUMBERS[Numbers_combn[p][1]];
+		for (int y = 0; y < positions.size(); y++)
+		{
+			Numbers_combn[p].push_back(NUMBERS[positions[y]]);
+		}
+		//display_stdvector(Numbers_combn[p]);
+	}
+	return Numbers_combn;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Search ranking
+// The order in which the sets of operations and the starting pairs are searched is learnt from a
+// corpus of solved games (see train_ranking). Games are grouped into profiles by how many large 
+// numbers they have and which third of 101-999 the target falls in, and for each profile we count
+// how often each set of operations and each starting pair held a solution. Starting pairs are 
+// described by the sizes of the two numbers, e.g. (largest, 3rd largest). The counts live in a
+// small text file loaded at startup; without it the static order of make_oper_table is used.
+const int PROFILE_LARGE = 5, PROFILE_BANDS = 3, NUM_PAIRS = 15;
+struct Ranking
+{
+	bool loaded = false;
+	long long games[PROFILE_LARGE][PROFILE_BANDS] = {};
+	long long opers[PROFILE_LARGE][PROFILE_BANDS][MAX_OPERS] = {};
+	long long pairs[PROFILE_LARGE][PROFILE_BANDS][NUM_PAIRS] = {};
+};
+
+int profile_large(const std::vector<int>& numbers)
+{
+	int large = 0;
+	for (int x : numbers) { if (x > 10) { large++; } }
+	return std::min(large, PROFILE_LARGE - 1);
+}
+int profile_band(int Target)
+{
+	return std::max(0, std::min((Target - 100) / 300, PROFILE_BANDS - 1));
+}
+// Which pair of sizes starts row p of make_numbers_combn, numbered like makeCombi(6, 2)
+int pair_class(const std::vector<int>& numbers, int p)
+{
+	std::vector<int> order = { 0,1,2,3,4,5 }, rank(6);
+	std::stable_sort(order.begin(), order.end(), [&](int x, int y) { return numbers[x] > numbers[y]; });
+	for (int k = 0; k < 6; k++) { rank[order[k]] = k; }
+	int i = 0, j = 0;
+	for (int a = 0, q = 0; a < 6; a++) { for (int b = a + 1; b < 6; b++, q++) { if (q == p) { i = a; j = b; } } }
+	int a = std::min(rank[i], rank[j]), b = std::max(rank[i], rank[j]);
+	return a * (11 - a) / 2 + (b - a - 1);
+}
+
+// File format, one block per profile:
+//		profile <large numbers> <target band> games <n>
+//		opers <hits for each of the Oper_table sets>
+//		pairs <hits for each of the 15 starting pairs>
+bool load_ranking(const std::string& file, Ranking& R)
+{
+	std::ifstream in(file);
+	if (!in) { return false; }
+	Ranking tmp;
+	std::string word;
+	while (in >> word)
+	{
+		if (word[0] == '#') { std::getline(in, word); continue; }
+		int l, b; long long n; std::string games;
+		if (word != "profile" || !(in >> l >> b >> games >> n) || l < 0 || l >= PROFILE_LARGE || b < 0 || b >= PROFILE_BANDS) { return false; }
+		tmp.games[l][b] = n;
+		if (!(in >> word) || word != "opers") { return false; }
+		for (int t = 0; t < Oper_table.size; t++) { if (!(in >> tmp.opers[l][b][t])) { return false; } }
+		if (!(in >> word) || word != "pairs") { return false; }
+		for (int p = 0; p < NUM_PAIRS; p++) { if (!(in >> tmp.pairs[l][b][p])) { return false; } }
+	}
+	tmp.loaded = true;
+	R = tmp;
+	return true;
+}
+bool save_ranking(const std::string& file, const Ranking& R)
+{
+	std::ofstream out(file);
+	if (!out) { return false; }
+	out << "# Countdown search ranking: solutions found per set of operations / starting pair\n";
+	out << "# for each profile of (large numbers, target band 101-399 / 400-699 / 700-999)\n";
+	for (int l = 0; l < PROFILE_LARGE; l++)
+	{
+		for (int b = 0; b < PROFILE_BANDS; b++)
+		{
+			out << "profile " << l << " " << b << " games " << R.games[l][b] << "\nopers";
+			for (int t = 0; t < Oper_table.size; t++) { out << " " << R.opers[l][b][t]; }
+			out << "\npairs";
+			for (int p = 0; p < NUM_PAIRS; p++) { out << " " << R.pairs[l][b][p]; }
+			out << "\n";
+		}
+	}
+	return true;
+}
+
+// The sets of operations (indices into Oper_table) in the order to search them
+std::vector<int> rank_opers(const Ranking& R, const std::vector<int>& numbers, int Target)
+{
+	std::vector<int> opers;
+	for (int t = 0; t < Oper_table.size; t++) { opers.push_back(t); }
+	if (!R.loaded) { return opers; }
+	const long long* hits = R.opers[profile_large(numbers)][profile_band(Target)];
+	std::stable_sort(opers.begin(), opers.end(), [&](int x, int y) { return hits[x] > hits[y]; });
+	return opers;
+}
+// The rows of make_numbers_combn in the order to search them
+std::vector<int> rank_pairs(const Ranking& R, const std::vector<int>& numbers, int Target)
+{
+	std::vector<int> pairs, cls;
+	for (int p = 0; p < NUM_PAIRS; p++) { pairs.push_back(p); cls.push_back(pair_class(numbers, p)); }
+	if (!R.loaded) { return pairs; }
+	const long long* hits = R.pairs[profile_large(numbers)][profile_band(Target)];
+	std::stable_sort(pairs.begin(), pairs.end(), [&](int x, int y) { return hits[cls[x]] > hits[cls[y]]; });
+	return pairs;
+}
+
+// Builds the ranking from games random games (drawn with the same seed each time so the file can be
+// rebuilt exactly). Every (set of operations, starting pair) part of the search is run for each game
+// and counted as a hit if it holds a solution.
+void train_ranking(int games, const std::string& file, unsigned seed)
+{
+	Ranking R;
+	ThreadPool pool;
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<> large_distr(0, 4), target_distr(101, 999);
+	for (int g = 0; g < games; g++)
+	{
+		int large = large_distr(gen);
+		std::vector<int> NUMBERS = random_draw(large, gen);
+		int Target = target_distr(gen);
+		std::vector<std::vector<int>> Numbers_combn = make_numbers_combn(NUMBERS);
+		std::vector<char> hit(Oper_table.size * NUM_PAIRS, 0);
+		for (int t = 0; t < Oper_table.size; t++)
+		{
+			for (int p = 0; p < NUM_PAIRS; p++)
+			{
+				pool.submit([&, t, p]()
+				{
+					for (int j = 0; j < Oper_table.Count[t] && !hit[t * NUM_PAIRS + p]; j++)
+					{
+						if (eval_(compile_game(Numbers_combn[p], Oper_table.Orders[t][j]), Perm_table, Target)) { hit[t * NUM_PAIRS + p] = 1; }
+					}
+				});
+			}
+		}
+		pool.wait();
+		int l = profile_large(NUMBERS), b = profile_band(Target);
+		R.games[l][b]++;
+		for (int t = 0; t < Oper_table.size; t++)
+		{
+			for (int p = 0; p < NUM_PAIRS; p++)
+			{
+				if (hit[t * NUM_PAIRS + p]) { R.opers[l][b][t]++; R.pairs[l][b][pair_class(NUMBERS, p)]++; }
+			}
+		}
+		if ((g + 1) % 100 == 0) { std::cout << "        " << g + 1 << " / " << games << " games" << std::endl; }
+	}
+	if (save_ranking(file, R)) { std::cout << "        Ranking written to " << file << std::endl; }
+	else { std::cout << "        Could not write " << file << std::endl; }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Solving a game
+// Runs the chosen engine on one game. The RPN search splits each game into slices of the 
+// permutation table, every (game, slice) pair is one task for the pool. All the tasks are queued up
+// front, most promising first (see rank_opers); the workers stop themselves as soon as a solution 
+// is published or the deadline passes.
+const char* status_name(SolveStatus st)
+{
+	const char* names[] = { "solved", "nearest", "none", "not_found", "timeout" };
+	return names[st];
+}
+
+// ------------------------------------------------------------------------------------------------
+// Solution database
+// There are only 13243 different draws of six tiles and 899 targets, so every standard game can be
+// solved ahead of time (with the DP solver) and looked up instead of searched for. The database file
+// is mapped into memory and laid out as
+//		header		magic, number of draws, range of targets
+//		index		for every multiset of tiles (how many of each small number 0-2, large 0-1), the 
+//					draw number + 1, 0 for multisets that are not a legal draw
+//		entries		one 64 bit entry per (draw, target)
+// so a lookup is two array reads. An entry holds the distance of the best result from the target in
+// the top 4 bits (0 solved, 1-10 nearest, 15 nothing within range), whether it is above the target,
+// and the result in RPN in the low 44 bits: 11 tokens of 4 bits, 1-6 for a number of the (sorted) 
+// draw, 8-11 for an operation and 0 for the end.
+const char DB_MAGIC[8] = { 'C','D','N','S','D','B','1','\0' };
+const int DB_TARGET_MIN = 101, DB_TARGET_MAX = 999, DB_INDEX_SIZE = 59049 * 16, DB_NONE = 15;
+const int LARGE_TILES[4] = { 25,50,75,100 };
+struct DBHeader
+{
+	char magic[8];
+	std::uint32_t draws, target_min, target_max, index_size;
+	std::uint32_t reserved[10];
+};
+
+// Position of a multiset of tiles in the index, -1 if it cannot be drawn
+int draw_key(const std::vector<int>& numbers)
+{
+	int small[11] = {}, large = 0;
+	for (int x : numbers)
+	{
+		if (x >= 1 && x <= 10) { small[x]++; continue; }
+		int k = std::find(LARGE_TILES, LARGE_TILES + 4, x) - LARGE_TILES;
+		if (k == 4 || (large >> k) & 1) { return -1; }
+		large |= 1 << k;
+	}
+	int key = 0;
+	for (int v = 10; v >= 1; v--)
+	{
+		if (small[v] > 2) { return -1; }
+		key = key * 3 + small[v];
+	}
+	return key * 16 + large;
+}
+
+// The solution held in an RPN entry
+SolutionTrace db_trace(std::uint64_t entry, const std::vector<int>& sorted)
+{
+	SolutionTrace t{};
+	for (int k = 0; k < 11; k++)
+	{
+		int tok = (entry >> (4 * k)) & 15;
+		if (tok == 0) { break; }
+		t.tokens[t.length++] = (tok <= 6) ? sorted[tok - 1] : -(tok - 7);
+	}
+	return t;
+}
+
+class SolutionDB
+{
+public:
+	SolutionDB() {}
+	SolutionDB(const SolutionDB&) = delete;
+	SolutionDB& operator=(const SolutionDB&) = delete;
+	~SolutionDB() { close(); }
+
+	bool open(const std::string& file)
+	{
+		close();
+#ifdef _WIN32
+		file_handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file_handle == INVALID_HANDLE_VALUE) { return false; }
+		LARGE_INTEGER sz;
+		GetFileSizeEx(file_handle, &sz);
+		size = sz.QuadPart;
+		map_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (map_handle != NULL) { data = (const unsigned char*)MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0); }
+#else
+		int fd = ::open(file.c_str(), O_RDONLY);
+		if (fd < 0) { return false; }
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			size = st.st_size;
+			void* p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+			if (p != MAP_FAILED) { data = (const unsigned char*)p; }
+		}
+		::close(fd);
+#endif
+		if (data == nullptr) { close(); return false; }
+		// Check the file is what we expect before trusting any of it
+		const DBHeader* h = header();
+		size_t expected = sizeof(DBHeader) + DB_INDEX_SIZE * sizeof(std::uint16_t) + (size_t)h->draws * (h->target_max - h->target_min + 1) * sizeof(std::uint64_t);
+		if (size < sizeof(DBHeader) || std::memcmp(h->magic, DB_MAGIC, 8) != 0 || h->index_size != DB_INDEX_SIZE || size != expected) { close(); return false; }
+		return true;
+	}
+	void close()
+	{
+#ifdef _WIN32
+		if (data) { UnmapViewOfFile(data); }
+		if (map_handle) { CloseHandle(map_handle); }
+		if (file_handle != INVALID_HANDLE_VALUE) { CloseHandle(file_handle); }
+		map_handle = NULL; file_handle = INVALID_HANDLE_VALUE;
+#else
+		if (data) { munmap((void*)data, size); }
+#endif
+		data = nullptr; size = 0;
+	}
+	bool is_open() const { return data != nullptr; }
+
+	// Fills in res and returns true if the game is in the database
+	bool lookup(const std::vector<int>& numbers, int Target, GameResult& res) const
+	{
+		if (!data || numbers.size() != 6) { return false; }
+		const DBHeader* h = header();
+		int key = draw_key(numbers);
+		if (key < 0 || Target < (int)h->target_min || Target > (int)h->target_max) { return false; }
+		const std::uint16_t* index = (const std::uint16_t*)(data + sizeof(DBHeader));
+		if (index[key] == 0) { return false; }
+		const std::uint64_t* entries = (const std::uint64_t*)(index + DB_INDEX_SIZE);
+		std::uint64_t entry = entries[(size_t)(index[key] - 1) * (h->target_max - h->target_min + 1) + (Target - h->target_min)];
+		int dist = entry >> 60;
+		res.tried = 0;
+		res.from_db = true;
+		res.exhaustive = true;
+		if (dist == DB_NONE) { res.status = NO_SOLUTION; res.distance = 0; res.solution = SolutionTrace{}; return true; }
+		std::vector<int> sorted = numbers;
+		std::sort(sorted.begin(), sorted.end());
+		res.status = (dist == 0) ? SOLVED : NEAREST;
+		res.distance = dist;
+		res.solution = db_trace(entry, sorted);
+		return true;
+	}
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file_handle = INVALID_HANDLE_VALUE, map_handle = NULL;
+#endif
+	const DBHeader* header() const { return (const DBHeader*)data; }
+};
+
+// Appends the RPN tokens (in the database encoding) for value made from the numbers in mask
+void dp_rpn(const DPTable& R, int mask, long long value, std::vector<int>& tokens)
+{
+	const DPStep& st = R[mask].at(value);
+	if (st.op == 0)
+	{
+		int i = 0;
+		while (!((mask >> i) & 1)) { i++; }
+		tokens.push_back(i + 1);
+		return;
+	}
+	dp_rpn(R, st.left_mask, st.left, tokens);
+	dp_rpn(R, mask ^ st.left_mask, st.right, tokens);
+	tokens.push_back(7 - st.op);
+}
+
+// Every legal draw (sorted) in order of draw_key
+std::vector<std::vector<int>> legal_draws()
+{
+	std::vector<std::vector<int>> draws;
+	for (int key = 0; key < DB_INDEX_SIZE; key++)
+	{
+		std::vector<int> draw;
+		for (int k = 0; k < 4; k++) { if ((key >> k) & 1) { draw.push_back(LARGE_TILES[k]); } }
+		for (int v = 1, rest = key / 16; v <= 10; v++, rest /= 3) { for (int c = 0; c < rest % 3; c++) { draw.push_back(v); } }
+		if (draw.size() != 6) { continue; }
+		std::sort(draw.begin(), draw.end());
+		draws.push_back(draw);
+	}
+	return draws;
+}
+
+// The database entries for every target of one draw
+void db_entries(const std::vector<int>& draw, int target_min, int target_max, std::uint64_t* out)
+{
+	DPTable R;
+	dp_build(draw, R);
+	std::unordered_map<long long, int> where; // value -> a subset that makes it
+	for (int mask = 1; mask < R.size(); mask++)
+	{
+		for (auto& x : R[mask]) { where.insert({ x.first, mask }); }
+	}
+	for (int T = target_min; T <= target_max; T++)
+	{
+		std::uint64_t entry = (std::uint64_t)DB_NONE << 60;
+		for (int d = 0; d <= NEAREST_RANGE && (entry >> 60) == DB_NONE; d++)
+		{
+			for (long long value : { T - d, T + d })
+			{
+				auto it = where.find(value);
+				if (it == where.end()) { continue; }
+				std::vector<int> tokens;
+				dp_rpn(R, it->second, value, tokens);
+				entry = ((std::uint64_t)d << 60) | ((std::uint64_t)(value > T) << 59);
+				for (int k = 0; k < tokens.size(); k++) { entry |= (std::uint64_t)tokens[k] << (4 * k); }
+				break;
+			}
+		}
+		out[T - target_min] = entry;
+	}
+}
+
+// Writes the header and index of the database for draws, the entries follow in the same order
+void write_db_head(std::ofstream& out, const std::vector<std::vector<int>>& draws)
+{
+	std::vector<std::uint16_t> index(DB_INDEX_SIZE, 0);
+	for (int d = 0; d < draws.size(); d++) { index[draw_key(draws[d])] = d + 1; }
+	DBHeader h = {};
+	std::memcpy(h.magic, DB_MAGIC, 8);
+	h.draws = draws.size(); h.target_min = DB_TARGET_MIN; h.target_max = DB_TARGET_MAX; h.index_size = DB_INDEX_SIZE;
+	out.write((const char*)&h, sizeof(h));
+	out.write((const char*)index.data(), index.size() * sizeof(std::uint16_t));
+}
+
+// Solves every (draw, target) and writes the database to file
+bool build_db(const std::string& file, ThreadPool& pool)
+{
+	std::vector<std::vector<int>> draws = legal_draws();
+	int targets = DB_TARGET_MAX - DB_TARGET_MIN + 1;
+	std::vector<std::uint64_t> entries((size_t)draws.size() * targets);
+	std::atomic<int> done{ 0 };
+	for (int d = 0; d < draws.size(); d++)
+	{
+		pool.submit([&, d]()
+		{
+			db_entries(draws[d], DB_TARGET_MIN, DB_TARGET_MAX, &entries[(size_t)d * targets]);
+			if (++done % 1000 == 0) { std::cerr << "        " << done << " / " << draws.size() << " draws" << std::endl; }
+		});
+	}
+	pool.wait();
+	std::ofstream out(file, std::ios::binary);
+	write_db_head(out, draws);
+	out.write((const char*)entries.data(), entries.size() * sizeof(std::uint64_t));
+	return (bool)out;
+}
+
+#ifndef _WIN32
+// ------------------------------------------------------------------------------------------------
+// Sharded database build
+// For builds that have to survive being stopped, the draws are split into DB_SHARDS shards of
+// consecutive draws, each solved by a worker process of its own. A worker appends every draw it
+// solves to the shard's segment and, every DB_CHECKPOINT draws, syncs the segment and records how
+// many draws it holds in the shard's checkpoint (written aside and renamed into place). A worker
+// that is stopped loses at most the draws since its last checkpoint: the next run cuts the segment
+// back to the checkpoint and carries on from there. Once every shard is done the segments are
+// merged into the database, in order, and removed. All of it lives in file.parts/ meanwhile:
+//		shard-NNN.seg	for every draw solved, the draw number then its entries (64 bits each)
+//		shard-NNN.ckpt	DB_MAGIC, DB_SHARDS, the shard and the draws done
+const int DB_SHARDS = 64, DB_CHECKPOINT = 16;
+struct ShardCheckpoint
+{
+	char magic[8];
+	std::uint32_t shards, shard, done;
+};
+
+std::string shard_file(const std::string& dir, int shard, const char* ext)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "/shard-%03d.%s", shard, ext);
+	return dir + name;
+}
+// The draws of shard s are first <= d < last
+int shard_first(int draws, int s) { return (int)((long long)draws * s / DB_SHARDS); }
+
+bool write_fd(int fd, const void* data, size_t n)
+{
+	size_t done = 0;
+	while (done < n)
+	{
+		ssize_t k = write(fd, (const char*)data + done, n - done);
+		if (k < 0 && errno == EINTR) { continue; }
+		if (k <= 0) { return false; }
+		done += k;
+	}
+	return true;
+}
+
+// Draws done according to the shard's checkpoint, 0 without one (or with one from another build)
+int shard_done(const std::string& dir, int shard)
+{
+	ShardCheckpoint c = {};
+	int fd = ::open(shard_file(dir, shard, "ckpt").c_str(), O_RDONLY);
+	if (fd < 0) { return 0; }
+	bool ok = read(fd, &c, sizeof(c)) == sizeof(c);
+	::close(fd);
+	if (!ok || std::memcmp(c.magic, DB_MAGIC, 8) != 0 || c.shards != DB_SHARDS || c.shard != shard) { return 0; }
+	return c.done;
+}
+
+bool save_checkpoint(const std::string& dir, int shard, int done)
+{
+	ShardCheckpoint c = {};
+	std::memcpy(c.magic, DB_MAGIC, 8);
+	c.shards = DB_SHARDS; c.shard = shard; c.done = done;
+	std::string file = shard_file(dir, shard, "ckpt"), tmp = file + ".tmp";
+	int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) { return false; }
+	bool ok = write_fd(fd, &c, sizeof(c)) && fsync(fd) == 0;
+	::close(fd);
+	ok = ok && std::rename(tmp.c_str(), file.c_str()) == 0;
+	if (!ok) { std::remove(tmp.c_str()); }
+	return ok;
+}
+
+// Run by a worker process: solves the draws of shard carrying on from its checkpoint
+bool solve_shard(const std::string& dir, const std::vector<std::vector<int>>& draws, int shard)
+{
+	int first = shard_first(draws.size(), shard), last = shard_first(draws.size(), shard + 1);
+	int targets = DB_TARGET_MAX - DB_TARGET_MIN + 1;
+	int fd = ::open(shard_file(dir, shard, "seg").c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0) { return false; }
+	// The lock goes with the process, so it only fails while a worker of an earlier run is still going
+	if (flock(fd, LOCK_EX | LOCK_NB) != 0) { ::close(fd); return false; }
+	int done = std::min(shard_done(dir, shard), last - first);
+	std::vector<std::uint64_t> record(1 + targets);
+	bool ok = ftruncate(fd, (off_t)done * record.size() * sizeof(std::uint64_t)) == 0 && lseek(fd, 0, SEEK_END) >= 0;
+	for (int d = first + done; d < last && ok; d++)
+	{
+		record[0] = d;
+		db_entries(draws[d], DB_TARGET_MIN, DB_TARGET_MAX, &record[1]);
+		ok = write_fd(fd, record.data(), record.size() * sizeof(std::uint64_t));
+		if (ok && (++done % DB_CHECKPOINT == 0 || d + 1 == last)) { ok = fsync(fd) == 0 && save_checkpoint(dir, shard, done); }
+	}
+	::close(fd);
+	return ok;
+}
+
+// Writes the database from the segments of every shard, checking each holds the draws it should
+bool merge_shards(const std::string& dir, const std::string& file, const std::vector<std::vector<int>>& draws)
+{
+	int targets = DB_TARGET_MAX - DB_TARGET_MIN + 1;
+	std::string tmp = file + ".tmp";
+	std::ofstream out(tmp, std::ios::binary);
+	write_db_head(out, draws);
+	std::vector<std::uint64_t> record(1 + targets);
+	bool ok = (bool)out;
+	for (int s = 0; s < DB_SHARDS && ok; s++)
+	{
+		std::ifstream in(shard_file(dir, s, "seg"), std::ios::binary);
+		for (int d = shard_first(draws.size(), s); d < shard_first(draws.size(), s + 1) && ok; d++)
+		{
+			ok = in.read((char*)record.data(), record.size() * sizeof(std::uint64_t)) && record[0] == d;
+			if (ok) { ok = (bool)out.write((const char*)&record[1], targets * sizeof(std::uint64_t)); }
+		}
+	}
+	out.close();
+	ok = ok && out && std::rename(tmp.c_str(), file.c_str()) == 0;
+	if (!ok) { std::remove(tmp.c_str()); } // no half written database left next to the real one
+	return ok;
+}
+#endif
+
+// Every game of the RPN search is split into this many slices of the permutation table
+const int SLICES = 8;
+
+// The games to search for NUMBERS, most likely to hold a solution first. Copies[g] counts the other
+// starting pairs that game g stands for (see below).
+std::vector<Game> compile_games(const std::vector<int>& NUMBERS, int Target, const Ranking& ranking, std::vector<int>& Copies)
+{
+	// =========================================================
+	// IMPORTANT data: 
+	/*		- Table of permutations - Perm_table
+			- Table of distinct operations - Oper_table (searched in the order of opers)
+			- Vector of distinct Numbers - Numbers_combn
+	*/
+	// =========================================================
+	std::vector<std::vector<int>> Numbers_combn = make_numbers_combn(NUMBERS);
+	// The sets of operations and starting pairs to search, most likely to hold a solution first
+	std::vector<int> opers = rank_opers(ranking, NUMBERS, Target), pairs = rank_pairs(ranking, NUMBERS, Target);
+	// Repeated tiles make some starting pairs the same two numbers, which leave the same four numbers
+	// to permute and so make exactly the same games. Only the first of them (in ranked order) is kept,
+	// copies counts the others it stands for.
+	std::vector<int> distinct, copies(Numbers_combn.size(), 0);
+	for (int p : pairs)
+	{
+		int a = std::min(Numbers_combn[p][0], Numbers_combn[p][1]), b = std::max(Numbers_combn[p][0], Numbers_combn[p][1]), k = 0;
+		while (k < distinct.size() && !(std::min(Numbers_combn[distinct[k]][0], Numbers_combn[distinct[k]][1]) == a && std::max(Numbers_combn[distinct[k]][0], Numbers_combn[distinct[k]][1]) == b)) { k++; }
+		if (k == distinct.size()) { distinct.push_back(p); }
+		else { copies[distinct[k]]++; }
+	}
+	// Compile the games we will iterate over for each set of operations (this will be a multiple of the 
+	// distinct pairs) so the search itself never has to build or parse any strings.
+	std::vector<Game> Games;
+	Copies.clear();
+	for (int t = 0; t < opers.size(); t++)
+	{
+		for (int i = 0; i < distinct.size(); i++)
+		{
+			for (int j = 0; j < Oper_table.Count[opers[t]]; j++)
+			{
+				Games.push_back(compile_game(Numbers_combn[distinct[i]], Oper_table.Orders[opers[t]][j]));
+				Copies.push_back(copies[distinct[i]]);
+			}
+		}
+	}
+	return Games;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Scheduling
+// The search is split into units of LANES games (one in nearest mode) by one slice of the table of
+// permutations, and the units are run best first. The first 1 / EAGER_SHARE of them are taken in
+// the order of the search ranking straight away, which is where most games are solved. If that
+// does not solve the game, a few rows spread over each slice of every game left are evaluated in full
+// (PROBE_ROWS of them, a fraction of a percent of the table) and the rest of the units are run in
+// order of the closest any of their probes came to the target, ties going to the ranking. A probe
+// making the target is a solution in its own right and ends the search there.
+// One task per worker takes units in order from a shared counter, so units start best first
+// whichever worker gets to them, and once the search has stopped (or the deadline has passed) every
+// task returns before its next unit. After UNITS_PER_TASK units a task puts itself back on the pool
+// so the games being solved at the same time take turns.
+const int EAGER_SHARE = 128;
+const int PROBE_ROWS = 2;
+const int UNITS_PER_TASK = 16;
+
+// The closest the sampled rows of game v between first and last come to T. Returns the row making T
+// (or -1) in hit.
+int probe(const Game& v, int T, int first, int last, int& hit)
+{
+	int closest = std::numeric_limits<int>::max();
+	hit = -1;
+	for (int k = 0; k < PROBE_ROWS; k++)
+	{
+		int i = first + (last - first) * k / PROBE_ROWS;
+		const std::uint8_t* perm = Perm_table.Rows[i];
+		int stack[MAX_STACK + 1] = { v[0],v[1] }, top = 1;
+		for (int m = 0; m < PERM_LEN; m++)
+		{
+			int tok = v[perm[m]];
+			if (tok >= 0) { stack[++top] = tok; continue; }
+			int a = stack[top - 1], b = stack[top--];
+			if ((tok == SUB && a <= b) || (tok == DIV && a % b != 0)) { break; }
+			stack[top] = (int)apply_op(tok, a, b);
+			if (std::abs(stack[top] - T) < closest) { closest = std::abs(stack[top] - T); }
+			if (stack[top] == T) { hit = i; return 0; }
+		}
+	}
+	return closest;
+}
+
+// Probes units order[from] on (unit u being games u / SLICES * step on, step of them, by slice
+// u % SLICES) and sorts them best first. Publishes the solution if a probe finds one.
+void rank_units(const std::vector<Game>& Games, int T, int step, std::vector<int>& order, int from, SearchState& S)
+{
+	int rows = Perm_table.size;
+	std::vector<int> closest(order.size(), std::numeric_limits<int>::max());
+	for (int k = from; k < order.size(); k++)
+	{
+		if (k % SLICES == 0 && S.timed_out()) { return; }
+		int u = order[k], first = rows * (u % SLICES) / SLICES, last = rows * (u % SLICES + 1) / SLICES;
+		for (int g = u / SLICES * step; g < std::min((u / SLICES + 1) * step, (int)Games.size()); g++)
+		{
+			int hit;
+			closest[u] = std::min(closest[u], probe(Games[g], T, first, last, hit));
+			if (hit >= 0) { S.publish(g, hit); return; }
+		}
+	}
+	std::stable_sort(order.begin() + from, order.end(), [&](int x, int y) { return closest[x] < closest[y]; });
+}
+
+// The RPN search is built for six numbers and works in 32 bits, which is safe as long as the product
+// of the numbers fits (counting a 1 as 2, since 1 + 1 is more than 1 * 1): no value can be larger.
+bool fits_rpn(const std::vector<int>& numbers)
+{
+	if (numbers.size() != 6) { return false; }
+	double bound = 1;
+	for (int x : numbers) { bound *= std::max(x, 2); }
+	return bound <= std::numeric_limits<int>::max();
+}
+
+// db (if given and open) is checked first, standard games are answered from it without searching.
+// Games the RPN search cannot take (see fits_rpn) are solved with the dp solver whatever the engine.
+GameResult solve_game(ThreadPool& pool, const std::vector<int>& NUMBERS, int Target, const Ranking& ranking, const std::string& engine, bool nearest, double seconds, const SolutionDB* db)
+{
+	auto start1 = std::chrono::steady_clock::now();
+	auto deadline = start1 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+	GameResult res{};
+	res.status = NOT_FOUND;
+	if (db && db->lookup(NUMBERS, Target, res))
+	{
+		res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start1).count();
+		return res;
+	}
+	if (engine == "dp" || !fits_rpn(NUMBERS))
+	{
+		DPResult dp = dp_solve(NUMBERS, Target, &pool, deadline);
+		res.status = (dp.status == DP_SOLVED) ? SOLVED : (dp.status == DP_NEAREST) ? NEAREST : (dp.status == DP_NONE) ? NO_SOLUTION : TIMED_OUT;
+		res.solution = dp.solution;
+		res.distance = (dp.status == DP_SOLVED || dp.status == DP_NEAREST) ? (int)std::abs(dp.value - Target) : 0;
+		res.tried = dp.values;
+		res.exhaustive = true;
+		res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start1).count();
+		return res;
+	}
+	std::vector<int> Copies;
+	std::vector<Game> Games = compile_games(NUMBERS, Target, ranking, Copies);
+	SearchState search;
+	search.deadline = deadline;
+	int rows = Perm_table.size;
+	// In nearest mode the DP solver tells us how close it is possible to get, so the search can stop
+	// as soon as it gets that close (or not start at all when nothing is within range).
+	bool in_range = true;
+	if (nearest)
+	{
+		DPResult bound = dp_solve(NUMBERS, Target, &pool, search.deadline);
+		search.nearest = true;
+		search.goal = (bound.status == DP_TIMED_OUT) ? 0 : (int)std::abs(bound.value - Target);
+		in_range = bound.status != DP_NONE;
+	}
+	// Nearest mode needs to know which game made each value, so it evaluates the games one at a time
+	int step = nearest ? 1 : LANES;
+	std::vector<int> order(in_range ? (Games.size() + step - 1) / step * SLICES : 0);
+	for (int u = 0; u < order.size(); u++) { order[u] = u; }
+	std::atomic<int> next{ 0 };
+	int end = 0;
+	ThreadPool::Group group;
+	std::function<void()> runner = [&]()
+	{
+		for (int k = 0; k < UNITS_PER_TASK; k++)
+		{
+			if (search.stop.load(std::memory_order_relaxed) || search.timed_out()) { return; }
+			int u = next++;
+			if (u >= end) { return; }
+			int id = order[u] / SLICES * step, q = order[u] % SLICES;
+			int first = rows * q / SLICES, last = rows * (q + 1) / SLICES;
+			for (int g = id; g < std::min(id + step, (int)Games.size()); g++) { count_repeats((long long)Copies[g] * (last - first)); }
+#ifdef VECTORISED
+			if (nearest) { eval_(Games[id], Perm_table, Target, first, last, search, id); }
+			else { eval_lanes(&Games[id], std::min(LANES, (int)Games.size() - id), Perm_table, Target, first, last, search, id); }
+#else
+			eval_(Games[id], Perm_table, Target, first, last, search, id);
+#endif
+		}
+		pool.submit(group, runner); // to the back of the queue, behind any other game's tasks
+	};
+	// Runs units order[next] up to end
+	auto run = [&](int to)
+	{
+		end = to;
+		for (int w = 0; w < std::min(pool.size(), end - next.load()); w++) { pool.submit(group, runner); }
+		pool.wait(group);
+		next = std::min(next.load(), end);
+	};
+	run(order.size() / EAGER_SHARE);
+	if (!search.stop)
+	{
+		rank_units(Games, Target, step, order, next, search);
+		run(order.size());
+	}
+	res.tried = search.tried;
+	if (search.solved())
+	{
+		res.status = SOLVED;
+		res.solution = make_trace(Games[search.hit_game()], Perm_table.Rows[search.hit_row()], Target);
+	}
+	// Otherwise rebuild the closest result from where it was recorded
+	else if (nearest && search.best.load() != SearchState::NO_RESULT && search.best_distance() <= NEAREST_RANGE)
+	{
+		res.status = NEAREST;
+		res.distance = search.best_distance();
+		int value = Target + (search.best_above() ? res.distance : -res.distance);
+		res.solution = make_trace(Games[search.best_game()], Perm_table.Rows[search.best_row()], value);
+	}
+	else if (!in_range) { res.status = NO_SOLUTION; }
+	else if (std::chrono::steady_clock::now() >= search.deadline) { res.status = TIMED_OUT; }
+	// A closest result may have been cut short by the deadline too, in which case it need not be the closest
+	res.stopped = !search.solved() && std::chrono::steady_clock::now() >= search.deadline;
+	res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start1).count();
+	return res;
+}
+
+// ------------------------------------------------------------------------------------------------
+// All solutions
+// Rather than stopping at the first solution every game is searched to the end, with each solution
+// handed to the caller as soon as it is found. Workers put solutions on a bounded queue and wait
+// while it is full, so a slow consumer holds the search back instead of the solutions piling up in
+// memory. The same solution is often found again (a different order of the operands of a sum, or
+// numbers left unused below it on the stack), so solutions are told apart by the hash of their
+// canonical form: workers drop one they have just seen and the consumer drops every other repeat.
+struct FoundSolution
+{
+	SolutionTrace trace;
+	std::uint64_t hash;
+};
+class SolutionQueue
+{
+public:
+	explicit SolutionQueue(size_t capacity) : capacity(capacity) {}
+	void push(const FoundSolution& s)
+	{
+		std::unique_lock<std::mutex> lock(m);
+		not_full.wait(lock, [this]() { return items.size() < capacity; });
+		items.push_back(s);
+		not_empty.notify_one();
+	}
+	// Returns false once the queue is closed and empty
+	bool pop(FoundSolution& s)
+	{
+		std::unique_lock<std::mutex> lock(m);
+		not_empty.wait(lock, [this]() { return !items.empty() || closed; });
+		if (items.empty()) { return false; }
+		s = items.front();
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+	// No more solutions will be pushed
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		closed = true;
+		not_empty.notify_all();
+	}
+private:
+	size_t capacity;
+	std::mutex m;
+	std::condition_variable not_full, not_empty;
+	std::deque<FoundSolution> items;
+	bool closed = false;
+};
+
+// Only games the RPN search can take (see fits_rpn) are searched, the others are not_found. 
+AllSolutions solve_all_game(ThreadPool& pool, const std::vector<int>& NUMBERS, int Target, const Ranking& ranking, const std::function<bool(const SolutionTrace&)>& found, double seconds)
+{
+	auto start1 = std::chrono::steady_clock::now();
+	AllSolutions res = { NOT_FOUND, 0, 0, 0, 0 };
+	if (!fits_rpn(NUMBERS)) { return res; }
+	std::vector<int> Copies;
+	std::vector<Game> Games = compile_games(NUMBERS, Target, ranking, Copies);
+	SearchState search;
+	search.deadline = start1 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+	SolutionQueue queue(1024);
+	std::vector<std::atomic<std::uint64_t>> recent(4096);	// the last solution seen in each slot
+	std::atomic<long long> made{ 0 };
+	search.found = [&](int game, int row, int pos)
+	{
+		FoundSolution s = { make_trace(Games[game], Perm_table.Rows[row], -1, pos + 2), 0 };
+		s.hash = std::hash<std::string>()(canonical_form(s.trace));
+		made++;
+		if (recent[s.hash % recent.size()].exchange(s.hash, std::memory_order_relaxed) == s.hash) { return; }
+		queue.push(s);
+	};
+	// Every slice of every game is a task, the last one to finish closes the queue
+	int rows = Perm_table.size;
+	std::atomic<int> left{ (int)Games.size() * SLICES };
+	ThreadPool::Group group;
+	for (int id = 0; id < Games.size(); id++)
+	{
+		for (int q = 0; q < SLICES; q++)
+		{
+			pool.submit(group, [&, id, q]()
+			{
+				int first = rows * q / SLICES, last = rows * (q + 1) / SLICES;
+				count_repeats((long long)Copies[id] * (last - first));
+				eval_(Games[id], Perm_table, Target, first, last, search, id);
+				if (--left == 0) { queue.close(); }
+			});
+		}
+	}
+	if (Games.empty()) { queue.close(); }
+	// The caller's thread hands the solutions over, once found returns false the search is stopped
+	// and whatever is still on its way is drained
+	std::unordered_set<std::uint64_t> seen;
+	bool wanted = true;
+	FoundSolution s;
+	while (queue.pop(s))
+	{
+		if (!wanted || !seen.insert(s.hash).second) { continue; }
+		res.solutions++;
+		if (!found(s.trace)) { wanted = false; search.stop = true; }
+	}
+	pool.wait(group);
+	res.found = made;
+	res.tried = search.tried;
+	// Nothing but the deadline stops the search unless found asked for it
+	res.status = (wanted && search.stop) ? TIMED_OUT : (res.solutions > 0) ? SOLVED : NO_SOLUTION;
+	res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start1).count();
+	return res;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Result cache
+// The same games come up again and again (the same tiles with popular targets), so finished results
+// are kept and handed back without searching. Games are keyed by their numbers in sorted order and
+// the target, so any order of the same tiles hits. Every result is kept apart from those the
+// deadline stopped short (timeouts, and nearest results that may not be the closest), which depend
+// on the deadline rather than the game.
+// The cache is split into shards by hash of the key, each with its own lock and least recently used
+// list, so lookups from different threads rarely wait on each other. Each shard gets an equal part 
+// of the memory bound and drops its least recently used games once it goes over.
+class ResultCache
+{
+public:
+	explicit ResultCache(size_t max_bytes) : shard_bytes(max_bytes / SHARDS)
+	{
+		for (int i = 0; i < SHARDS; i++) { shards.emplace_back(new Shard); }
+	}
+	static std::string key(const std::vector<int>& numbers, int Target)
+	{
+		std::vector<int> sorted = numbers;
+		std::sort(sorted.begin(), sorted.end());
+		std::string k;
+		for (int x : sorted) { k += std::to_string(x) + " "; }
+		return k + std::to_string(Target);
+	}
+	bool get(const std::string& k, GameResult& res)
+	{
+		Shard& sh = shard(k);
+		std::lock_guard<std::mutex> lock(sh.m);
+		auto it = sh.map.find(k);
+		if (it == sh.map.end()) { misses++; return false; }
+		sh.lru.splice(sh.lru.begin(), sh.lru, it->second); // most recently used to the front
+		res = it->second->res;
+		hits++;
+		return true;
+	}
+	void put(const std::string& k, const GameResult& res)
+	{
+		size_t size = entry_bytes(k);
+		if (size > shard_bytes) { return; }
+		Shard& sh = shard(k);
+		std::lock_guard<std::mutex> lock(sh.m);
+		if (sh.map.count(k)) { return; } // solved by someone else meanwhile
+		sh.lru.push_front({ k, res, size });
+		sh.map[k] = sh.lru.begin();
+		sh.bytes += size;
+		while (sh.bytes > shard_bytes && !sh.lru.empty())
+		{
+			Entry& old = sh.lru.back();
+			sh.bytes -= old.bytes; // as charged, copies of the key need not have the same capacity
+			sh.map.erase(old.key);
+			sh.lru.pop_back();
+			evictions++;
+		}
+	}
+	CacheStats stats()
+	{
+		CacheStats st = { hits, misses, evictions, 0, 0 };
+		for (auto& sh : shards)
+		{
+			std::lock_guard<std::mutex> lock(sh->m);
+			st.entries += sh->map.size();
+			st.bytes += sh->bytes;
+		}
+		return st;
+	}
+private:
+	static const int SHARDS = 16;
+	struct Entry
+	{
+		std::string key;
+		GameResult res;
+		size_t bytes;	// charged to the shard when it was put
+	};
+	typedef std::list<Entry> List;
+	struct Shard
+	{
+		std::mutex m;
+		List lru;
+		std::unordered_map<std::string, List::iterator> map;
+		size_t bytes = 0;
+	};
+	std::vector<std::unique_ptr<Shard>> shards;
+	size_t shard_bytes;
+	std::atomic<long long> hits{ 0 }, misses{ 0 }, evictions{ 0 };
+
+	Shard& shard(const std::string& k) { return *shards[std::hash<std::string>()(k) % SHARDS]; }
+	// Roughly what an entry costs: the list node, the map node and both strings (the key twice)
+	static size_t entry_bytes(const std::string& k)
+	{
+		return sizeof(List::value_type) + 2 * sizeof(void*) + sizeof(std::pair<std::string, List::iterator>) + 2 * sizeof(void*)
+			+ 2 * k.size();
+	}
+};
+
+// ------------------------------------------------------------------------------------------------
+// Solver
+// Everything a game needs that can be set up ahead of time is kept here and reused between games.
+bool build_db(const std::string& file, int threads)
+{
+	ThreadPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+	return build_db(file, pool);
+}
+
+bool build_db_sharded(const std::string& file, int processes)
+{
+#ifdef _WIN32
+	return build_db(file, processes);
+#else
+	std::vector<std::vector<int>> draws = legal_draws();
+	std::string dir = file + ".parts";
+	if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) { return false; }
+	std::vector<int> todo;
+	for (int s = 0; s < DB_SHARDS; s++)
+	{
+		if (shard_done(dir, s) < shard_first(draws.size(), s + 1) - shard_first(draws.size(), s)) { todo.push_back(s); }
+	}
+	int done = DB_SHARDS - todo.size(), failed = 0, next = 0;
+	if (done > 0) { std::cerr << "        " << done << " / " << DB_SHARDS << " shards done by an earlier run" << std::endl; }
+	// Up to processes workers at once, each solving one shard and exiting
+	pid_t parent = getpid();
+	std::unordered_map<pid_t, int> running;
+	while (next < todo.size() || !running.empty())
+	{
+		while (next < todo.size() && running.size() < std::max(processes, 1))
+		{
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+#ifdef __linux__
+				prctl(PR_SET_PDEATHSIG, SIGKILL); // a worker never outlives the build
+#endif
+				if (getppid() != parent) { _exit(1); }
+				_exit(solve_shard(dir, draws, todo[next]) ? 0 : 1);
+			}
+			if (pid < 0) { std::cerr << "Could not start a worker process: " << std::strerror(errno) << std::endl; failed++; next++; continue; }
+			running[pid] = todo[next++];
+		}
+		if (running.empty()) { break; }
+		int status;
+		pid_t pid = wait(&status);
+		if (pid < 0) { if (errno == EINTR) { continue; } break; }
+		int shard = running[pid];
+		running.erase(pid);
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0) { std::cerr << "        " << ++done << " / " << DB_SHARDS << " shards" << std::endl; }
+		else { std::cerr << "Shard " << shard << " failed, run again to carry on from its checkpoint" << std::endl; failed++; }
+	}
+	if (failed > 0 || !running.empty() || !merge_shards(dir, file, draws)) { return false; }
+	for (int s = 0; s < DB_SHARDS; s++)
+	{
+		unlink(shard_file(dir, s, "seg").c_str());
+		unlink(shard_file(dir, s, "ckpt").c_str());
+	}
+	rmdir(dir.c_str());
+	return true;
+#endif
+}
+
+struct Solver::Impl
+{
+	SolverOptions options;
+	ThreadPool pool;
+	Ranking ranking;
+	SolutionDB db;
+	bool db_ok = false;
+	ResultCache cache;
+
+	explicit Impl(const SolverOptions& opts) : options(opts), pool(opts.threads > 0 ? opts.threads : std::thread::hardware_concurrency()), cache(opts.cache_bytes)
+	{
+		if (!options.ranking_file.empty()) { load_ranking(options.ranking_file, ranking); }
+		db_ok = options.db_file.empty() || db.open(options.db_file);
+	}
+};
+
+Solver::Solver(const SolverOptions& options) : impl(new Impl(options)) {}
+Solver::~Solver() {}
+
+// Games the solvers can take: 1 to MAX_TILES numbers and a target, all positive (the RPN search
+// reads negative numbers as operations and the dp solver divides by them)
+bool valid_game(const std::vector<int>& numbers, int target)
+{
+	if (numbers.empty() || numbers.size() > MAX_TILES || target <= 0) { return false; }
+	return *std::min_element(numbers.begin(), numbers.end()) > 0;
+}
+
+GameResult Solver::solve(const std::vector<int>& numbers, int target, double deadline)
+{
+	const SolverOptions& o = impl->options;
+	auto start1 = std::chrono::steady_clock::now();
+	if (!valid_game(numbers, target))
+	{
+		GameResult res{};
+		res.status = NOT_FOUND;
+		return res;
+	}
+	std::string key;
+	if (o.cache_bytes > 0)
+	{
+		GameResult res;
+		key = ResultCache::key(numbers, target);
+		if (impl->cache.get(key, res))
+		{
+			res.tried = 0;
+			res.from_cache = true;
+			res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start1).count();
+			return res;
+		}
+	}
+	GameResult res = solve_game(impl->pool, numbers, target, impl->ranking, o.engine, o.nearest, deadline, impl->db.is_open() ? &impl->db : nullptr);
+	// Results from the database are just as quick to find again, and results the deadline stopped
+	// short depend on the deadline rather than the game
+	if (o.cache_bytes > 0 && !res.from_db && res.status != TIMED_OUT && !res.stopped) { impl->cache.put(key, res); }
+	return res;
+}
+
+AllSolutions Solver::solve_all(const std::vector<int>& numbers, int target, const std::function<bool(const SolutionTrace&)>& found, double deadline)
+{
+	if (!valid_game(numbers, target)) { return { NOT_FOUND, 0, 0, 0, 0 }; }
+	return solve_all_game(impl->pool, numbers, target, impl->ranking, found, deadline);
+}
+
+const SolverOptions& Solver::options() const { return impl->options; }
+bool Solver::has_ranking() const { return impl->ranking.loaded; }
+bool Solver::has_db() const { return impl->db_ok; }
+CacheStats Solver::cache_stats() const { return impl->cache.stats(); }
+
+SolverMetrics Solver::metrics() const
+{
+	SolverMetrics M;
+	M.total = {};
+	for (int i = 0; i < impl->pool.size(); i++)
+	{
+		const WorkerSlot& w = impl->pool.counters(i);
+		WorkerCounters c = {};
+		c.evaluations = w.evaluations; c.positions = w.positions; c.depth = w.depth; c.repeats = w.repeats;
+		c.solutions = w.solutions; c.tasks = w.tasks; c.busy_ms = w.busy_ns / 1e6;
+		for (int r = 0; r < NUM_PRUNES; r++) { c.prunes[r] = w.prunes[r]; }
+		M.workers.push_back(c);
+		M.total.evaluations += c.evaluations; M.total.positions += c.positions; M.total.depth += c.depth; M.total.repeats += c.repeats;
+		M.total.solutions += c.solutions; M.total.tasks += c.tasks; M.total.busy_ms += c.busy_ms;
+		for (int r = 0; r < NUM_PRUNES; r++) { M.total.prunes[r] += c.prunes[r]; }
+	}
+	M.cache = impl->cache.stats();
+	return M;
+}
+
+std::string counters_json(const WorkerCounters& c)
+{
+	std::ostringstream out;
+	out << "{\"evaluations\":" << c.evaluations << ",\"positions\":" << c.positions << ",\"average_depth\":"
+		<< (c.evaluations ? (double)c.depth / c.evaluations : 0) << ",\"prunes\":{";
+	for (int r = 0; r < NUM_PRUNES; r++) { out << (r ? "," : "") << "\"" << prune_name(r) << "\":" << c.prunes[r]; }
+	out << "},\"repeats\":" << c.repeats << ",\"solutions\":" << c.solutions << ",\"tasks\":" << c.tasks << ",\"busy_ms\":" << c.busy_ms << "}";
+	return out.str();
+}
+std::string metrics_json(const SolverMetrics& M)
+{
+	std::ostringstream out;
+	out << "{\"total\":" << counters_json(M.total) << ",\"workers\":[";
+	for (int i = 0; i < M.workers.size(); i++) { out << (i ? "," : "") << counters_json(M.workers[i]); }
+	out << "],\"cache\":{\"hits\":" << M.cache.hits << ",\"misses\":" << M.cache.misses << ",\"evictions\":" << M.cache.evictions
+		<< ",\"entries\":" << M.cache.entries << ",\"bytes\":" << M.cache.bytes << "}}\n";
+	return out.str();
+}
+std::string metrics_prometheus(const SolverMetrics& M)
+{
+	std::ostringstream out;
+	// One metric per counter, labelled by worker
+	auto metric = [&](const char* name, const char* type, const char* help, auto value)
+	{
+		out << "# HELP countdown_" << name << " " << help << "\n# TYPE countdown_" << name << " " << type << "\n";
+		for (int i = 0; i < M.workers.size(); i++) { out << "countdown_" << name << "{worker=\"" << i << "\"} " << value(M.workers[i]) << "\n"; }
+	};
+	metric("evaluations_total", "counter", "Permutations evaluated.", [](const WorkerCounters& c) { return c.evaluations; });
+	metric("positions_total", "counter", "Positions of permutations evaluated.", [](const WorkerCounters& c) { return c.positions; });
+	metric("depth_total", "counter", "Total of the positions reached by each permutation evaluated.", [](const WorkerCounters& c) { return c.depth; });
+	metric("repeats_total", "counter", "Permutations not searched as they repeat another with equal numbers or operations.", [](const WorkerCounters& c) { return c.repeats; });
+	metric("solutions_total", "counter", "Solutions found.", [](const WorkerCounters& c) { return c.solutions; });
+	metric("tasks_total", "counter", "Tasks run.", [](const WorkerCounters& c) { return c.tasks; });
+	metric("busy_seconds_total", "counter", "Time spent running tasks.", [](const WorkerCounters& c) { return c.busy_ms / 1000; });
+	out << "# HELP countdown_prunes_total Permutations abandoned, by rule.\n# TYPE countdown_prunes_total counter\n";
+	for (int i = 0; i < M.workers.size(); i++)
+	{
+		for (int r = 0; r < NUM_PRUNES; r++) { out << "countdown_prunes_total{worker=\"" << i << "\",rule=\"" << prune_name(r) << "\"} " << M.workers[i].prunes[r] << "\n"; }
+	}
+	out << "# HELP countdown_cache_hits_total Games answered from the result cache.\n# TYPE countdown_cache_hits_total counter\ncountdown_cache_hits_total " << M.cache.hits << "\n";
+	out << "# HELP countdown_cache_misses_total Games not in the result cache.\n# TYPE countdown_cache_misses_total counter\ncountdown_cache_misses_total " << M.cache.misses << "\n";
+	out << "# HELP countdown_cache_evictions_total Games dropped from the result cache.\n# TYPE countdown_cache_evictions_total counter\ncountdown_cache_evictions_total " << M.cache.evictions << "\n";
+	out << "# HELP countdown_cache_entries Games held in the result cache.\n# TYPE countdown_cache_entries gauge\ncountdown_cache_entries " << M.cache.entries << "\n";
+	out << "# HELP countdown_cache_bytes Memory used by the result cache.\n# TYPE countdown_cache_bytes gauge\ncountdown_cache_bytes " << M.cache.bytes << "\n";
+	return out.str();
+}
@@ -0,0 +1,164 @@
+// =============================================================================================
+// **************************      Countdown numbers game solver     ***************************
+// =============================================================================================
+// The solver library used by the game (Countdown.cpp). Everything needed to solve a game lives
+// behind the Solver class: the permutation and operation tables (built by the compiler), the pool
+// of worker threads, the search ranking and the solution database are all set up once when the
+// Solver is made and reused for every game it is asked to solve, e.g.
+//
+//			Solver solver;
+//			GameResult res = solver.solve({ 25,8,10,7,1,5 }, 988, 30);
+//			if (res.status == SOLVED) { std::cout << format_infix(res.solution); }	// 988 = ...
+//
+// solve() can be called from several threads at once, the games then share the worker threads.
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include<string>
+#include<vector>
+#include<memory>
+#include<random>
+#include<functional>
+
+// Countdown awards points for getting within 10 of the target
+const int NEAREST_RANGE = 10;
+// Most numbers a game can have. The standard game has six, variants have more (or fewer).
+const int MAX_TILES = 8;
+
+// A solution as the search found it, in reverse Polish notation: each token is one of the numbers
+// or an operation, stored as -1 for +, -2 for *, -3 for - and -4 for /. For example 25 8 -2 1 -3 is
+// (25 * 8) - 1. Solutions stay in this form and are only written out as text when asked for.
+struct SolutionTrace
+{
+	int length;				// tokens used, 0 if nothing was found
+	int tokens[2 * MAX_TILES - 1];
+};
+// The value the solution makes (in 64 bits, as the values on the way there may not fit in 32)
+long long trace_value(const SolutionTrace& t);
+// "988 = ((25 * 8) - 1)" or "0" if nothing was found
+std::string format_infix(const SolutionTrace& t);
+// "25 8 * 1 -" or "" if nothing was found
+std::string format_rpn(const SolutionTrace& t);
+// {"value":988,"rpn":[25,8,"*",1,"-"]} or null if nothing was found
+std::string format_json(const SolutionTrace& t);
+
+enum SolveStatus { SOLVED, NEAREST, NO_SOLUTION, NOT_FOUND, TIMED_OUT };
+struct GameResult
+{
+	SolveStatus status;
+	SolutionTrace solution;	// length 0 if nothing was found
+	int distance;			// of the solution from the target
+	long long tried;		// permutations covered (rpn) or values made (dp)
+	double ms;				// time taken
+	bool from_db;			// answered by the solution database (so the nearest result is exact)
+	bool from_cache;		// answered by the result cache of an earlier solve
+	bool stopped;			// the deadline stopped the search (a nearest result may not be the closest)
+	bool exhaustive;		// answered by the dp solver or the database, which try everything (so a
+							// nearest result is the closest there is)
+};
+// The outcome of searching a game for all of its solutions (see Solver::solve_all)
+struct AllSolutions
+{
+	SolveStatus status;		// solved, none, timeout (with the solutions found so far) or not_found
+	long long solutions;	// distinct solutions handed over
+	long long found;		// solutions made by the search, repeats included
+	long long tried;		// permutations covered
+	double ms;				// time taken
+};
+// "solved", "nearest", "none", "not_found" or "timeout"
+const char* status_name(SolveStatus st);
+
+struct SolverOptions
+{
+	std::string engine = "rpn";					// rpn search or dp (subset dynamic programming)
+	bool nearest = false;						// give the closest result when there is no solution
+	std::string ranking_file = "ranking.txt";	// search ranking, the static order is used without it
+	std::string db_file;						// solution database, none if empty
+	int threads = 0;							// worker threads, 0 for one per core
+	size_t cache_bytes = 16 << 20;				// memory bound of the result cache, 0 for no cache
+};
+
+struct CacheStats
+{
+	long long hits, misses, evictions;
+	long long entries, bytes;		// held in the cache now
+};
+
+// Counters of the work done by each worker thread (see Solver::metrics). The rules eval_ uses to 
+// abandon a permutation early are counted separately to show which of them pay off. PRUNE_REPEAT
+// abandons permutations that only swap two equal numbers (or operations) of another permutation,
+// PRUNE_COMMUTE and PRUNE_ASSOCIATE those making a sum or product another permutation makes in
+// canonical form (larger operand first, chains bracketed from the left).
+enum PruneRule { PRUNE_MUL_ONE, PRUNE_SUB_NOT_POSITIVE, PRUNE_SUB_EQUAL, PRUNE_DIV_FRACTION, PRUNE_DIV_EQUAL, PRUNE_DIV_ONE, PRUNE_REPEAT, PRUNE_COMMUTE, PRUNE_ASSOCIATE, NUM_PRUNES };
+struct WorkerCounters
+{
+	long long evaluations;			// permutations evaluated (not those skipped with an abandoned prefix)
+	long long positions;			// positions evaluated, not counting prefixes shared with the row before
+	long long depth;				// total of the positions reached, depth / evaluations is the average
+	long long prunes[NUM_PRUNES];	// permutations abandoned by each rule
+	long long repeats;				// permutations not searched as they repeat another (equal numbers or operations)
+	long long solutions;
+	long long tasks;
+	double busy_ms;					// time spent running tasks
+};
+struct SolverMetrics
+{
+	std::vector<WorkerCounters> workers;
+	WorkerCounters total;
+	CacheStats cache;
+};
+// "mul_one", "sub_not_positive", "sub_equal", "div_fraction", "div_equal", "div_one", "repeat",
+// "commute" or "associate"
+const char* prune_name(int rule);
+std::string metrics_json(const SolverMetrics& M);
+// In the Prometheus text format, e.g. for the node exporter's textfile collector
+std::string metrics_prometheus(const SolverMetrics& M);
+
+class Solver
+{
+public:
+	explicit Solver(const SolverOptions& options = SolverOptions());
+	~Solver();
+	Solver(const Solver&) = delete;
+	Solver& operator=(const Solver&) = delete;
+
+	// Solves one game of up to MAX_TILES numbers, giving up after deadline seconds. Six numbers are
+	// solved with the engine of the options, any other number of them with the dp solver (as are
+	// numbers so large that a value could overflow 32 bits, the dp solver works in 64 bits). More 
+	// than MAX_TILES numbers (or none), and numbers or a target that are not positive, are not_found
+	// straight away.
+	GameResult solve(const std::vector<int>& numbers, int target, double deadline = 30);
+	// Searches a game to the end, handing every distinct solution to found as soon as it turns up
+	// (on the calling thread) rather than stopping at the first. Solutions are distinct when they
+	// differ by more than the order of the operands of sums and products, and are those within reach
+	// of the RPN search (its sets of operations and pruning rules). Returning false from found stops 
+	// the search. The search waits for found when it gets too far ahead, so memory does not grow with
+	// the solutions beyond a hash of each to spot repeats. Only six numbers small enough for the RPN
+	// search are taken, anything else is not_found. Neither the database nor the result cache is used.
+	AllSolutions solve_all(const std::vector<int>& numbers, int target, const std::function<bool(const SolutionTrace&)>& found, double deadline = 30);
+
+	const SolverOptions& options() const;
+	bool has_ranking() const;
+	// False if a db_file was given but could not be opened
+	bool has_db() const;
+	CacheStats cache_stats() const;
+	// Counters since the Solver was made, can be read while games are being solved
+	SolverMetrics metrics() const;
+private:
+	struct Impl;
+	std::unique_ptr<Impl> impl;
+};
+
+// Draws tiles numbers at random, large from the large numbers and the rest from the small numbers
+std::vector<int> random_draw(int large, std::mt19937& gen, int tiles = 6);
+// Builds the search ranking from games random games and writes it to file
+void train_ranking(int games, const std::string& file, unsigned seed);
+// Solves every standard game with the dp solver and writes the solution database to file
+bool build_db(const std::string& file, int threads = 0);
+// The same as build_db in worker processes (up to processes at once), each solving a shard of the
+// draws and checkpointing as it goes in file.parts/, so a build that is stopped carries on from its
+// checkpoints when run again. The shards are merged into file once all are done. Workers are forked,
+// so call it before starting any threads. On Windows this is build_db with processes threads.
+bool build_db_sharded(const std::string& file, int processes);
+
+#endif